@@ -0,0 +1,54 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     CsAllocGuard - контроль отсутствия выделений динамической памяти в установившемся режиме
+
+     В контуре управления после запуска не должно быть ни одного выделения динамической
+     памяти. Библиотека RUPAllocGuard замещает malloc, calloc, realloc, memalign,
+     aligned_alloc, posix_memalign и free, а также глобальные operator new/delete,
+     в том числе выровненные формы с std::align_val_t, и ведет для каждого потока
+     счетчик выделений. Выделения внутри libc и libstdc++ (strdup, контейнеры)
+     проходят через замещенный malloc и тоже учитываются. После прогрева поток
+     вызывает csAllocArm(), и каждое последующее выделение в этом потоке учитывается
+     вместе со стеком вызовов (до CS_ALLOC_STACKS стеков). csAllocDisarm() завершает
+     контроль и возвращает количество выделений, а csAllocReport() выводит стеки вызовов.
+
+     Подключается только в программы контроля (компоновка с RUPAllocGuard), основная
+     библиотека функции выделения не замещает. Замещение malloc и стеки вызовов
+     доступны только с glibc, в остальных случаях учитывается только operator new.
+   */
+#ifndef CSALLOCGUARD_H
+#define CSALLOCGUARD_H
+
+#include <stdint.h>
+
+//Количество сохраняемых стеков вызовов выделений
+#define CS_ALLOC_STACKS   16
+
+//Глубина сохраняемого стека вызовов
+#define CS_ALLOC_DEPTH    16
+
+//!
+//! \brief csAllocArm Начать контроль выделений памяти в текущем потоке
+//!
+void     csAllocArm();
+
+//!
+//! \brief csAllocDisarm Завершить контроль выделений памяти в текущем потоке
+//! \return              Количество выделений с момента csAllocArm
+//!
+uint64_t csAllocDisarm();
+
+//!
+//! \brief csAllocCount Возвращает количество выделений памяти в текущем потоке с момента csAllocArm
+//! \return             Количество выделений
+//!
+uint64_t csAllocCount();
+
+//!
+//! \brief csAllocReport Вывести стеки вызовов выделений памяти текущего потока
+//! \param fd            Дескриптор файла для вывода
+//!
+void     csAllocReport( int fd );
+
+#endif // CSALLOCGUARD_H
@@ -0,0 +1,48 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     CsBatchDecode - пакетное декодирование ответов в структуру массивов
+
+     После выделения пачки ответов их декодирование по одному в разрозненные
+     структуры медленно и неудобно для последующих вычислений по всем сочленениям.
+     Ответы на команды "Управление" и "Получить информацию" имеют фиксированный
+     формат, поэтому положение каждого поля известно заранее: полезные 7-битные
+     группы ответа собираются в одно 64-битное слово, из которого поля извлекаются
+     сдвигами без последовательного состояния декодера (mUsedBits).
+
+     Декодирование ведется в два прохода блоками по CS_BATCH_BLOCK ответов:
+     сбор слов из циклического буфера и извлечение полей в массивы. Второй проход
+     не содержит ветвлений и векторизуется компилятором.
+
+     Ответы должны быть предварительно проверены (CsMessageIn::checkCrc). Полезные
+     группы собираются начиная с первого байта данных ответа (CsFrame::data()),
+     поэтому ответы с меткой декодируются так же, как ответы без нее.
+   */
+#ifndef CSBATCHDECODE_H
+#define CSBATCHDECODE_H
+
+#include "RUPBaseClass.hpp"
+
+//Количество ответов, обрабатываемых за один блок
+#define CS_BATCH_BLOCK 32
+
+//!
+//! \brief csDecodeControlAnswers Декодировать ответы на команду "Управление"
+//! \param frames                 Проверенные ответы
+//! \param count                  Количество ответов
+//! \param angles                 Массив текущих углов
+//! \param moments                Массив текущих моментов
+//!
+void csDecodeControlAnswers( const CsFrame *frames, int count, int16_t *angles, int16_t *moments );
+
+//!
+//! \brief csDecodeInfoAnswers Декодировать ответы на команду "Получить информацию"
+//! \param frames              Проверенные ответы
+//! \param count               Количество ответов
+//! \param info0               Массив значений 0
+//! \param info1               Массив значений 1
+//! \param info2               Массив значений 2
+//!
+void csDecodeInfoAnswers( const CsFrame *frames, int count, int16_t *info0, int16_t *info1, int16_t *info2 );
+
+#endif // CSBATCHDECODE_H
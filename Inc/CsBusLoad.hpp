@@ -0,0 +1,126 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     CsBusLoad - учет загрузки шины
+
+     Чтобы оценить, сколько еще устройств или какую частоту опроса выдержит шина,
+     для каждой шины ведется учет времени линии по выделенным парам запрос-ответ
+     (CsSniffRecord от анализатора или от собственного приемника хоста):
+       - время занятости линии - время передачи запроса и ответа, вычисленное по
+         их длине и скорости обмена, в том числе ответа с ошибкой КС;
+       - время реакции устройства - от окончания запроса до начала ответа,
+         линия в это время свободна, но для полудуплексной шины без меток
+         занята ожиданием;
+       - ожидание ответа на запрос без метки, оставшийся без ответа: хост не передает
+         следующий запрос до истечения времени ожидания, поэтому время до следующего
+         запроса (не больше времени ожидания) считается занятым;
+       - паузы между окончанием предыдущего обмена и началом следующего запроса.
+     Время реакции и паузы накапливаются в гистограммах CsHistogram фиксированного
+     размера. В режиме с метками обмены перекрываются, и пауза учитывается только
+     тогда, когда запрос начался после окончания всех предыдущих обменов.
+     Занятость шины - доля времени наблюдения без пауз, поэтому перекрывающиеся
+     обмены не учитываются дважды.
+
+     По накопленным значениям projected() оценивает занятость шины после
+     добавления новых обменов заданной частоты.
+   */
+#ifndef CSBUSLOAD_H
+#define CSBUSLOAD_H
+
+#include "CsHistogram.hpp"
+#include "CsRttEstimator.hpp"
+#include "CsSniffer.hpp"
+
+//!
+//! \brief The CsBusLoadStat struct счетчики загрузки одной шины
+//!
+struct CsBusLoadStat {
+    uint32_t    mExchanges;  //!< Количество учтенных запросов
+    uint32_t    mAnswers;    //!< Количество учтенных ответов
+    uint32_t    mMissing;    //!< Количество запросов без метки, оставшихся без ответа
+    uint32_t    mCorrupted;  //!< Количество ответов с ошибкой КС или прерванных
+    uint64_t    mBusyUs;     //!< Время передачи запросов и ответов, мкс
+    uint64_t    mWaitUs;     //!< Время ожидания ответов на запросы, оставшиеся без ответа, мкс
+    uint64_t    mElapsedUs;  //!< Время наблюдения от начала первого запроса до окончания последнего обмена, мкс
+    CsHistogram mIdle;       //!< Паузы между обменами
+    CsHistogram mTurnaround; //!< Время реакции устройств
+
+    CsBusLoadStat() : mExchanges(0), mAnswers(0), mMissing(0), mCorrupted(0), mBusyUs(0), mWaitUs(0), mElapsedUs(0) {}
+
+    //!
+    //! \brief utilization Возвращает долю времени передачи данных по линии
+    //! \return            Доля от 0 до 1
+    //!
+    double utilization() const { return mElapsedUs ? static_cast<double>(mBusyUs) / mElapsedUs : 0; }
+
+    //!
+    //! \brief occupancy Возвращает долю времени, занятого обменами (передача и ожидание ответов),
+    //! то есть долю времени наблюдения без пауз между обменами
+    //! \return          Доля от 0 до 1
+    //!
+    double occupancy() const { return mElapsedUs ? static_cast<double>(mElapsedUs - mIdle.mSum) / mElapsedUs : 0; }
+  };
+
+
+//!
+//! \brief The CsBusLoad class учет времени линии одной шины
+//!
+class CsBusLoad
+  {
+    int           mBaud;     //!< Скорость обмена, бод
+    int           mTimeout;  //!< Время ожидания ответа хостом после окончания запроса, мкс
+    bool          mStarted;  //!< Признак учета первого обмена
+    bool          mAwaiting; //!< Последний запрос остался без ответа, линия занята ожиданием
+    uint32_t      mLineEnd;  //!< Время окончания последнего обмена, мкс
+    CsBusLoadStat mStat;     //!< Счетчики загрузки
+  public:
+    //!
+    //! \brief CsBusLoad Конструктор учета
+    //! \param baud      Скорость обмена, бод
+    //! \param timeout   Время ожидания ответа хостом после окончания запроса, мкс
+    //!
+    CsBusLoad( int baud, int timeout = CS_RTT_MAX ) : mBaud(baud), mTimeout(timeout), mStarted(false), mAwaiting(false), mLineEnd(0) {}
+
+    //!
+    //! \brief account     Учесть обмен
+    //! \param queryEnd    Время окончания запроса, мкс
+    //! \param queryBytes  Длина запроса, байт
+    //! \param answerBytes Длина ответа, байт, или 0 если ответа нет
+    //! \param latency     Время реакции устройства, мкс, или -1 если ответа нет
+    //! \param awaited     true - на запрос без метки ожидался ответ, до его получения или
+    //!                    истечения времени ожидания следующий запрос не передается
+    //! \param corrupted   true - ответ принят с ошибкой КС или прерван: время передачи
+    //!                    учитывается, но ответ и время реакции не учитываются
+    //!
+    void account( uint32_t queryEnd, int queryBytes, int answerBytes, int32_t latency, bool awaited = false, bool corrupted = false );
+
+    //!
+    //! \brief record  Функция обработки пар запрос-ответ анализатора (CsSniffFn)
+    //! \param context Учет загрузки шины
+    //! \param record  Запрос и ответ
+    //!
+    static void record( void *context, const CsSniffRecord &record );
+
+    //!
+    //! \brief projected Оценить занятость шины после добавления обменов
+    //! \param exchanges Количество добавляемых обменов в цикле (например, число устройств)
+    //! \param cmd       Команда добавляемых обменов
+    //! \param rate      Частота цикла, Гц
+    //! \param tagged    true - добавляемые обмены передаются с меткой
+    //! \return          Ожидаемая доля времени, занятого обменами (больше 1 - шина перегружена)
+    //!
+    double projected( int exchanges, int cmd, int rate, bool tagged = false ) const;
+
+    //!
+    //! \brief stat Возвращает счетчики загрузки
+    //! \return     Счетчики
+    //!
+    const CsBusLoadStat &stat() const { return mStat; }
+
+    //!
+    //! \brief reset Сбросить счетчики загрузки
+    //!
+    void reset() { mStat = CsBusLoadStat(); mStarted = false; mAwaiting = false; }
+  };
+
+#endif // CSBUSLOAD_H
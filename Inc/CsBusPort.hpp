@@ -0,0 +1,178 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     CsBusPort - последовательный порт шины с быстрым восстановлением после
+                 повторного подключения адаптера USB-serial
+
+     При сбое адаптер USB-serial отключается и снова появляется в системе
+     (переподключение). Старый дескриптор при этом перестает работать (EIO, ENODEV),
+     а обнаружение по тайм-аутам и повторное открытие занимали секунды.
+
+     CsHotplug следит за каталогом /dev через inotify и сообщает о появлении и
+     исчезновении устройств. csHotplugApply закрывает порт при исчезновении его
+     устройства и сразу открывает заново при появлении (или смене прав доступа,
+     которую udev выполняет после создания узла). При повторном открытии
+     восстанавливаются сохраненные настройки termios.
+
+     Каждое успешное открытие увеличивает generation(). Поток обмена, обнаружив
+     новое значение, отбрасывает недоразобранные данные кольцевого буфера приема
+     (head = tail), так как оборванные запросы и ответы уже не будут дополнены,
+     и проверяет устройства CsSignatureSweep.
+
+     Реализация доступна только для Linux, на других платформах функции возвращают
+     признак неудачи.
+   */
+#ifndef CSBUSPORT_H
+#define CSBUSPORT_H
+
+#include <stdint.h>
+
+#ifdef __linux__
+#include <termios.h>
+#endif
+
+//Максимальная длина пути к порту
+#define CS_PORT_PATH_MAX 64
+
+//!
+//! \brief The CsBusPort class последовательный порт шины с сохранением настроек для повторного открытия
+//!
+class CsBusPort
+  {
+    int            mFd;                       //!< Дескриптор порта или -1
+    char           mPath[CS_PORT_PATH_MAX];   //!< Путь к порту
+    int            mBaud;                     //!< Скорость обмена, бод
+    uint32_t       mGeneration;               //!< Количество успешных открытий порта
+#ifdef __linux__
+    struct termios mTermios;                  //!< Настройки порта для повторного открытия
+    bool           mHaveTermios;              //!< Настройки сохранены
+#endif
+  public:
+    CsBusPort();
+    ~CsBusPort() { close(); }
+
+    CsBusPort( const CsBusPort& ) = delete;
+    CsBusPort &operator = ( const CsBusPort& ) = delete;
+
+    //!
+    //! \brief open Открыть порт и настроить его на обмен с шиной (8N1, без обработки символов)
+    //! \param path Путь к порту, например /dev/ttyUSB0
+    //! \param baud Скорость обмена, бод
+    //! \return     true при успешном открытии
+    //!
+    bool        open( const char *path, int baud );
+
+    //!
+    //! \brief reopen Повторно открыть порт с сохраненными настройками
+    //! \return       true при успешном открытии
+    //!
+    bool        reopen();
+
+    //!
+    //! \brief close Закрыть порт
+    //!
+    void        close();
+
+    //!
+    //! \brief read Прочитать доступные данные без ожидания. При потере устройства порт закрывается
+    //! \param dst  Буфер-приемник
+    //! \param size Размер буфера
+    //! \return     Количество прочитанных байтов, 0 если данных нет, -1 если порт закрыт
+    //!
+    int         read( char *dst, int size );
+
+    //!
+    //! \brief write Записать данные в порт. При потере устройства порт закрывается
+    //! \param data  Данные
+    //! \param size  Количество байтов
+    //! \return      Количество записанных байтов или -1, если порт закрыт
+    //!
+    int         write( const char *data, int size );
+
+    //!
+    //! \brief fd Возвращает дескриптор порта для ожидания poll/epoll
+    //! \return   Дескриптор или -1, если порт закрыт
+    //!
+    int         fd() const { return mFd; }
+
+    //!
+    //! \brief isOpen Проверить, открыт ли порт
+    //! \return       true, если порт открыт
+    //!
+    bool        isOpen() const { return mFd >= 0; }
+
+    //!
+    //! \brief name Возвращает имя порта без каталога, например ttyUSB0
+    //! \return     Имя порта
+    //!
+    const char *name() const;
+
+    //!
+    //! \brief generation Возвращает количество успешных открытий порта
+    //! \return           Номер открытия
+    //!
+    uint32_t    generation() const { return mGeneration; }
+  };
+
+
+
+//!
+//! \brief The CsHotplugEvent struct событие появления или исчезновения устройства
+//!
+struct CsHotplugEvent {
+    char mName[32]; //!< Имя устройства в /dev
+    bool mAdded;    //!< true - устройство появилось (или изменены его права), false - исчезло
+  };
+
+//!
+//! \brief The CsHotplug class следит за появлением и исчезновением устройств в /dev
+//!
+class CsHotplug
+  {
+    int mFd; //!< Дескриптор inotify или -1
+  public:
+    CsHotplug() : mFd(-1) {}
+    ~CsHotplug() { close(); }
+
+    CsHotplug( const CsHotplug& ) = delete;
+    CsHotplug &operator = ( const CsHotplug& ) = delete;
+
+    //!
+    //! \brief open Начать слежение
+    //! \param dir  Каталог устройств
+    //! \return     true при успешном запуске
+    //!
+    bool open( const char *dir = "/dev" );
+
+    //!
+    //! \brief close Прекратить слежение
+    //!
+    void close();
+
+    //!
+    //! \brief fd Возвращает дескриптор для ожидания событий poll/epoll
+    //! \return   Дескриптор или -1
+    //!
+    int  fd() const { return mFd; }
+
+    //!
+    //! \brief read   Прочитать накопленные события без ожидания
+    //! \param events Приемник событий
+    //! \param max    Максимальное количество событий, события сверх него в прочитанном блоке теряются
+    //! \return       Количество прочитанных событий
+    //!
+    int  read( CsHotplugEvent *events, int max );
+  };
+
+
+
+//!
+//! \brief csHotplugApply Закрыть порт при исчезновении его устройства и открыть при появлении
+//! \param port           Порт шины
+//! \param events         События CsHotplug
+//! \param count          Количество событий
+//! \return               true, если порт был открыт заново
+//!
+bool csHotplugApply( CsBusPort &port, const CsHotplugEvent *events, int count );
+
+#endif // CSBUSPORT_H
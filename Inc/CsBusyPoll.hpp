@@ -0,0 +1,127 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     CsBusyPoll - прием с шины непрерывным опросом порта
+
+     Пробуждение потока через epoll после поступления данных добавляет десятки
+     микросекунд разброса задержки. Для шины с самыми жесткими требованиями
+     к задержке прием может выполняться непрерывным опросом: поток, привязанный
+     к выделенному (изолированному, isolcpus/nohz_full) ядру, в цикле выполняет
+     неблокирующее чтение порта и сразу передает принятые байты разборщику.
+
+     Политика опроса CsPollPolicy определяет поведение при отсутствии данных:
+       - mSpin  пустых опросов подряд выполняется с инструкцией pause;
+       - затем mYield опросов с уступкой процессора (sched_yield);
+       - затем поток ждет данных в poll() не дольше mIdleUs; по истечении времени
+         ожидание повторяется, а непрерывный опрос возобновляется только после
+         поступления данных.
+     Порт с VMIN = 0 и VTIME = 0 при отсутствии данных может вернуть 0 байтов,
+     поэтому пустое чтение не считается ошибкой. Прием завершается с ошибкой,
+     если poll() сообщает о разрыве (POLLHUP, POLLERR) или чтение возвращает
+     ошибку, отличную от EAGAIN и EINTR.
+     Нулевые mSpin и mYield дают обычный прием по событиям.
+
+     Статистика CsPollStat позволяет оценить цену режима: долю занятости
+     процессора (время процессора потока к реальному времени) и долю пустых
+     опросов. Потребляемую мощность ядро в режиме опроса не снижает, поэтому
+     доля занятости близка к 1 и является ее оценкой.
+   */
+#ifndef CSBUSYPOLL_H
+#define CSBUSYPOLL_H
+
+#include <atomic>
+#include <stdint.h>
+
+//Размер блока чтения из порта
+#define CS_POLL_BLOCK 256
+
+//!
+//! \brief CsRxFn   Функция обработки принятых данных
+//! \param context  Контекст, переданный при создании приемника
+//! \param data     Принятые байты
+//! \param size     Количество байтов
+//! \param time     Время приема, мкс
+//!
+typedef void (*CsRxFn)( void *context, const char *data, int size, uint32_t time );
+
+//!
+//! \brief The CsPollPolicy struct политика непрерывного опроса
+//!
+struct CsPollPolicy {
+    uint32_t mSpin;   //!< Количество пустых опросов с pause до перехода к уступке процессора
+    uint32_t mYield;  //!< Количество пустых опросов с sched_yield до перехода к ожиданию
+    uint32_t mIdleUs; //!< Максимальное время ожидания данных в poll(), мкс
+    int      mCpu;    //!< Процессор, к которому привязывается поток приема, или -1
+
+    CsPollPolicy() : mSpin(1000000), mYield(1000), mIdleUs(1000), mCpu(-1) {}
+  };
+
+//!
+//! \brief The CsPollStat struct статистика приема
+//!
+struct CsPollStat {
+    uint64_t mPolls;   //!< Количество опросов порта
+    uint64_t mEmpty;   //!< Количество пустых опросов
+    uint64_t mYields;  //!< Количество уступок процессора
+    uint64_t mWaits;   //!< Количество ожиданий в poll()
+    uint64_t mBytes;   //!< Количество принятых байтов
+    uint64_t mWallUs;  //!< Реальное время работы цикла, мкс
+    uint64_t mCpuUs;   //!< Время процессора потока приема, мкс
+
+    CsPollStat() : mPolls(0), mEmpty(0), mYields(0), mWaits(0), mBytes(0), mWallUs(0), mCpuUs(0) {}
+
+    //!
+    //! \brief load Возвращает долю занятости процессора потоком приема
+    //! \return     Доля от 0 до 1
+    //!
+    double load() const { return mWallUs ? static_cast<double>(mCpuUs) / mWallUs : 0; }
+  };
+
+
+//!
+//! \brief The CsBusyPoll class цикл приема с непрерывным опросом порта
+//!
+class CsBusyPoll
+  {
+    CsPollPolicy  mPolicy;  //!< Политика опроса
+    CsRxFn        mHandler; //!< Функция обработки принятых данных
+    void         *mContext; //!< Контекст функции обработки
+    CsPollStat    mStat;    //!< Статистика приема
+  public:
+    //!
+    //! \brief CsBusyPoll Конструктор приемника
+    //! \param handler    Функция обработки принятых данных
+    //! \param context    Контекст функции обработки
+    //! \param policy     Политика опроса
+    //!
+    CsBusyPoll( CsRxFn handler, void *context, const CsPollPolicy &policy = CsPollPolicy() ) :
+      mPolicy(policy), mHandler(handler), mContext(context) {}
+
+    //!
+    //! \brief run  Выполнять прием до установки признака остановки или ошибки порта.
+    //! Если задан mCpu, текущий поток привязывается к этому процессору
+    //! \param fd   Дескриптор порта, открытого в неблокирующем режиме
+    //! \param stop Признак остановки
+    //! \return     true при остановке по признаку, false при ошибке порта
+    //!
+    bool run( int fd, const std::atomic<bool> &stop );
+
+    //!
+    //! \brief stat Возвращает статистику приема
+    //! \return     Статистика
+    //!
+    const CsPollStat &stat() const { return mStat; }
+
+    //!
+    //! \brief reset Сбросить статистику приема
+    //!
+    void reset() { mStat = CsPollStat(); }
+  };
+
+//!
+//! \brief csTimeUs Возвращает монотонное время
+//! \return         Время, мкс
+//!
+uint32_t csTimeUs();
+
+#endif // CSBUSYPOLL_H
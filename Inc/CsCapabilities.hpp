@@ -0,0 +1,131 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     CsCapabilities - согласование возможностей устройств при обнаружении
+
+     Версия протокола CS_MESSAGE_VERSION задается при компиляции, а устройство
+     не сообщает версию протокола, по которой можно было бы выбрать более быстрые
+     режимы обмена (CS_CB_PROTOCOL_ID - идентификатор протокола, а не его версия).
+     Поэтому возможности определяются пробным чтением, которое старые устройства
+     пройти не могут. При обнаружении устройств шины для каждого из них выполняется:
+       1. Чтение CS_CB_VERSION - версии программы устройства, подтверждает наличие
+          устройства.
+       2. Чтение таблицы возможностей CS_CB_CAPABILITIES. Таблица принимается, только
+          если старшие 16 бит значения равны CS_CAP_SIGNATURE. Устройства до версии
+          протокола 2 не знают этого параметра: они не отвечают или возвращают
+          произвольное значение без признака и работают только в классическом режиме.
+       3. Если устройство поддерживает ответы с метками и хост их разрешил - включение
+          режима записью CS_CB_TAGGED_ANSWERS.
+     Далее планировщик и кодировщики по supports() выбирают самый быстрый режим,
+     поддерживаемый устройством, и классические сообщения в остальных случаях.
+     Устройство, не ответившее на чтение версии программы, считается отсутствующим.
+   */
+#ifndef CSCAPABILITIES_H
+#define CSCAPABILITIES_H
+
+#include "RUPBaseClass.hpp"
+
+//!
+//! \brief The CsCapabilities class выполняет обнаружение и согласование возможностей устройств одной шины
+//!
+class CsCapabilities
+  {
+    //Этапы согласования устройства
+    enum Stage : uint8_t {
+      StageVersion,  //!< Чтение версии программы
+      StageCaps,     //!< Чтение таблицы возможностей
+      StageTagged,   //!< Включение ответов с метками
+      StageDone,     //!< Согласование завершено
+      StageAbsent    //!< Устройство не ответило
+      };
+
+    Stage    mStage[CS_DEVICE_COUNT];   //!< Этап согласования по устройствам
+    uint32_t mVersion[CS_DEVICE_COUNT]; //!< Версия программы устройства
+    uint16_t mCaps[CS_DEVICE_COUNT];    //!< Поддерживаемые возможности
+    uint16_t mActive[CS_DEVICE_COUNT];  //!< Включенные режимы
+    uint16_t mAllowed;                  //!< Возможности, разрешенные хостом
+    int      mCurrent;                  //!< Устройство, которому отправлен текущий запрос, или -1
+  public:
+    //!
+    //! \brief CsCapabilities Конструктор согласования
+    //! \param ids            Маска идентификаторов опрашиваемых устройств (бит id)
+    //! \param allowed        Возможности, которые хост готов использовать (CS_CAP_...)
+    //!
+    CsCapabilities( uint16_t ids = 0x7fff, uint16_t allowed = 0xffff );
+
+    //!
+    //! \brief makeNextQuery Сформировать очередной запрос согласования
+    //! \param msg           Кодировщик сообщения
+    //! \return              Идентификатор опрашиваемого устройства или -1, если согласование завершено
+    //!
+    template <class CsMessageOutTmpl>
+    int  makeNextQuery( CsMessageOutTmpl &msg )
+      {
+      mCurrent = next();
+      if( mCurrent < 0 ) return -1;
+      switch( mStage[mCurrent] ) {
+        case StageVersion : msg.makeQueryRead( mCurrent, CS_CB_VERSION ); break;
+        case StageCaps :    msg.makeQueryRead( mCurrent, CS_CB_CAPABILITIES ); break;
+        default :           msg.makeQueryWrite( mCurrent, CS_CB_TAGGED_ANSWERS, 1 ); break;
+        }
+      return mCurrent;
+      }
+
+    //!
+    //! \brief answer Обработать ответ на запрос согласования
+    //! \param value  Значение из ответа
+    //!
+    void answer( int value );
+
+    //!
+    //! \brief timeout Сообщить об отсутствии ответа на запрос согласования
+    //!
+    void timeout();
+
+    //!
+    //! \brief done Проверить завершение согласования всех устройств
+    //! \return     true, если согласование завершено
+    //!
+    bool done() const { return next() < 0; }
+
+    //!
+    //! \brief present Проверить наличие устройства
+    //! \param id      Идентификатор устройства
+    //! \return        true, если устройство ответило при обнаружении
+    //!
+    bool present( int id ) const { return mStage[id & 0xf] == StageDone; }
+
+    //!
+    //! \brief version Возвращает версию программы устройства
+    //! \param id      Идентификатор устройства
+    //! \return        Версия программы (CS_CB_VERSION) или 0, если устройство не обнаружено
+    //!
+    uint32_t version( int id ) const { return mVersion[id & 0xf]; }
+
+    //!
+    //! \brief supports Проверить, поддерживает ли устройство и разрешает ли хост возможность
+    //! \param id       Идентификатор устройства
+    //! \param cap      Возможность (CS_CAP_...)
+    //! \return         true, если возможность можно использовать
+    //!
+    bool supports( int id, uint16_t cap ) const { return (mCaps[id & 0xf] & mAllowed & cap) == cap; }
+
+    //!
+    //! \brief active Проверить, включен ли на устройстве режим (для режимов, требующих включения)
+    //! \param id     Идентификатор устройства
+    //! \param cap    Возможность (CS_CAP_...)
+    //! \return       true, если режим включен
+    //!
+    bool active( int id, uint16_t cap ) const { return (mActive[id & 0xf] & cap) == cap; }
+
+    //!
+    //! \brief supportedByAll Возвращает возможности, поддерживаемые всеми обнаруженными устройствами
+    //! \return               Маска возможностей
+    //!
+    uint16_t supportedByAll() const;
+
+  private:
+    int  next() const;
+  };
+
+#endif // CSCAPABILITIES_H
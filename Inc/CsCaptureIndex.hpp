@@ -0,0 +1,68 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     CsCaptureIndex - индекс запросов записи обмена по устройству и команде
+
+     При анализе записи обмена часто нужны все запросы одного двигателя или все
+     записи параметров. Индекс хранит для каждой пары (id, cmd) список смещений
+     запросов в записи, поэтому запрос вида "все CS_CMD_MSG_WRITE к устройству 3"
+     сразу получает нужные смещения без просмотра всей записи.
+
+     Запись представляет собой непрерывный поток принятых байтов (например,
+     отображенный в память файл). Благодаря старшему биту - признаку заголовка -
+     поток можно разбирать с любого места, поэтому запись делится на части,
+     которые разбираются параллельно выделителем CsFrameScanner. Запрос
+     принадлежит той части, в которой находится его заголовок.
+   */
+#ifndef CSCAPTUREINDEX_H
+#define CSCAPTUREINDEX_H
+
+#include "RUPBaseClass.hpp"
+
+#include <vector>
+
+//Количество кодов команд
+#define CS_CMD_COUNT 8
+
+//!
+//! \brief The CsCaptureIndex class индекс запросов записи обмена по паре (id, cmd)
+//!
+class CsCaptureIndex
+  {
+    std::vector<int64_t> mPostings[CS_DEVICE_COUNT][CS_CMD_COUNT]; //!< Смещения запросов по устройствам и командам
+    int64_t              mFrames;                                  //!< Общее количество запросов
+    int64_t              mErrors;                                  //!< Количество запросов с ошибкой КС
+  public:
+    CsCaptureIndex() : mFrames(0), mErrors(0) {}
+
+    //!
+    //! \brief build   Построить индекс записи обмена
+    //! \param data    Записанный поток байтов
+    //! \param size    Размер записи
+    //! \param threads Количество потоков разбора
+    //! \param tagged  Маска устройств, запросы к которым записаны с меткой
+    //!
+    void build( const char *data, int64_t size, int threads = 1, uint16_t tagged = 0 );
+
+    //!
+    //! \brief find Возвращает смещения всех запросов с командой cmd к устройству id в порядке возрастания
+    //! \param id   Идентификатор устройства
+    //! \param cmd  Команда
+    //! \return     Список смещений
+    //!
+    const std::vector<int64_t> &find( int id, int cmd ) const { return mPostings[id & 0xf][cmd & 0x7]; }
+
+    //!
+    //! \brief frames Возвращает общее количество проиндексированных запросов
+    //! \return       Количество запросов
+    //!
+    int64_t frames() const { return mFrames; }
+
+    //!
+    //! \brief errors Возвращает количество пропущенных запросов с ошибкой КС
+    //! \return       Количество ошибок
+    //!
+    int64_t errors() const { return mErrors; }
+  };
+
+#endif // CSCAPTUREINDEX_H
@@ -0,0 +1,148 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     CsClockSync - синхронизация времени устройства со временем хоста
+
+     Для совместной обработки данных двигателей, IMU и датчиков усилия необходимо
+     переводить время устройства во время хоста. Обмен строится на обычной команде
+     "Чтение параметра" (например, CS_CB_TIME_SEC_LOW модуля IMU): хост запоминает
+     время отправки запроса t1 и время приема ответа t4, устройство возвращает свое
+     время d. Как и в NTP, считается, что d соответствует середине интервала (t1+t4)/2,
+     а погрешность оценки не превышает половины времени обмена t4-t1.
+
+     Смещение и дрейф часов оцениваются альфа-бета фильтром (установившийся фильтр
+     Калмана для модели "смещение + постоянная скорость"). Отсчеты с временем обмена,
+     заметно превышающим минимальное, отбрасываются, так как их погрешность велика.
+
+     Запросы синхронизации не привязаны к циклу управления: планировщик вызывает
+     makeQuery только в свободных слотах шины, когда due() возвращает true.
+
+     Время хоста передается вызывающей стороной в микросекундах.
+   */
+#ifndef CSCLOCKSYNC_H
+#define CSCLOCKSYNC_H
+
+#include <stdint.h>
+
+//!
+//! \brief The CsClockSync class оценивает смещение и дрейф часов одного устройства
+//! относительно часов хоста по ответам на команду "Чтение параметра".
+//!
+class CsClockSync
+  {
+    int      mId;         //!< Идентификатор устройства
+    int      mIndex;      //!< Индекс параметра, содержащего время устройства
+    double   mTickUs;     //!< Длительность тика часов устройства, мкс
+    int64_t  mPeriod;     //!< Период запросов синхронизации, мкс
+    int64_t  mSendTime;   //!< Время отправки текущего запроса (t1), мкс
+    int64_t  mNextTime;   //!< Время, начиная с которого нужен следующий запрос, мкс
+    bool     mPending;    //!< Запрос отправлен, ответ еще не получен
+
+    bool     mHaveTicks;  //!< Принято хотя бы одно значение счетчика устройства
+    uint32_t mLastTicks;  //!< Последнее принятое значение счетчика устройства
+    int64_t  mWraps;      //!< Накопленные переполнения 32-битного счетчика устройства
+
+    int64_t  mMinRtt;     //!< Минимальное наблюдаемое время обмена, мкс
+    int64_t  mRefTime;    //!< Время хоста последнего принятого отсчета, мкс
+    double   mOffset;     //!< Смещение времени устройства относительно хоста на момент mRefTime, мкс
+    double   mDrift;      //!< Дрейф часов устройства относительно хоста (безразмерный)
+    int      mSamples;    //!< Количество принятых отсчетов
+    int      mRejected;   //!< Количество отброшенных отсчетов
+
+    int64_t unwrap( uint32_t ticks, int64_t wraps ) const;
+  public:
+    //!
+    //! \brief CsClockSync Конструктор синхронизатора
+    //! \param id          Идентификатор устройства
+    //! \param index       Индекс параметра, содержащего 32-битное время устройства
+    //! \param tickHz      Частота счетчика времени устройства, Гц
+    //! \param period      Период запросов синхронизации, мкс
+    //!
+    CsClockSync( int id, int index, uint32_t tickHz, int64_t period = 1000000 );
+
+    //!
+    //! \brief due Проверить, пора ли отправлять запрос синхронизации
+    //! \param now Текущее время хоста, мкс
+    //! \return    true, если запрос нужно отправить в ближайшем свободном слоте шины
+    //!
+    bool    due( int64_t now ) const { return !mPending && now >= mNextTime; }
+
+    //!
+    //! \brief makeQuery Сформировать запрос чтения времени устройства и запомнить время отправки
+    //! \param msg       Кодировщик сообщения
+    //! \param now       Время хоста при отправке запроса, мкс
+    //!
+    template <class CsMessageOutTmpl>
+    void    makeQuery( CsMessageOutTmpl &msg, int64_t now )
+      {
+      msg.makeQueryRead( mId, mIndex );
+      mSendTime = now;
+      mPending  = true;
+      }
+
+    //!
+    //! \brief answer Обработать ответ на запрос синхронизации
+    //! \param ticks  Время устройства из ответа (значение параметра)
+    //! \param now    Время хоста при приеме ответа, мкс
+    //! \return       true, если отсчет принят фильтром
+    //!
+    bool    answer( uint32_t ticks, int64_t now );
+
+    //!
+    //! \brief timeout Сообщить об отсутствии ответа на запрос синхронизации
+    //! \param now     Текущее время хоста, мкс
+    //!
+    void    timeout( int64_t now ) { mPending = false; mNextTime = now + mPeriod; }
+
+    //!
+    //! \brief deviceTime Преобразовать 32-битный счетчик устройства в 64-битное время устройства с учетом переполнений
+    //! \param ticks      Значение счетчика устройства
+    //! \return           Время устройства, мкс
+    //!
+    int64_t deviceTime( uint32_t ticks ) const;
+
+    //!
+    //! \brief hostTime   Перевести время устройства во время хоста
+    //! \param deviceTime Время устройства, мкс
+    //! \return           Время хоста, мкс
+    //!
+    int64_t hostTime( int64_t deviceTime ) const;
+
+    //!
+    //! \brief synced Проверить наличие оценки смещения
+    //! \return       true, если принят хотя бы один отсчет
+    //!
+    bool    synced() const { return mSamples > 0; }
+
+    //!
+    //! \brief offset Возвращает текущую оценку смещения времени устройства относительно хоста
+    //! \return       Смещение, мкс
+    //!
+    double  offset() const { return mOffset; }
+
+    //!
+    //! \brief driftPpm Возвращает оценку дрейфа часов устройства относительно хоста
+    //! \return      Дрейф, миллионные доли
+    //!
+    double  driftPpm() const { return mDrift * 1e6; }
+
+    //!
+    //! \brief minRtt Возвращает минимальное наблюдаемое время обмена
+    //! \return       Время обмена, мкс
+    //!
+    int64_t minRtt() const { return mMinRtt; }
+
+    //!
+    //! \brief samples Возвращает количество принятых отсчетов
+    //! \return        Количество отсчетов
+    //!
+    int     samples() const { return mSamples; }
+
+    //!
+    //! \brief rejected Возвращает количество отброшенных из-за большого времени обмена отсчетов
+    //! \return         Количество отсчетов
+    //!
+    int     rejected() const { return mRejected; }
+  };
+
+#endif // CSCLOCKSYNC_H
@@ -0,0 +1,166 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     CsCobs - альтернативное кадрирование обмена с хостом
+
+     Упаковка по 7 бит со старшим битом - признаком команда-данные нужна для
+     выделения сообщений в кольцевом буфере dma на линии двигателей. На быстрой
+     линии с хостом (USB) она стоит 12.5% пропускной способности и перестановки
+     битов. Поэтому для обмена с хостом предусмотрено альтернативное кадрирование
+     COBS (Consistent Overhead Byte Stuffing): данные передаются полными байтами,
+     а нулевой байт служит только разделителем сообщений. Накладные расходы - 1 байт
+     на каждые 254 байта данных.
+
+     Сообщение до кодирования
+       - заголовок: код команды (8 бит), только для запросов
+       - данные: целые числа в порядке от младшего байта к старшему
+       - КС: CRC-8 (csMessageCrc) заголовка и данных
+     После кодирования COBS добавляется разделитель 0.
+
+     Кадрирование согласуется записью параметра CS_CB_HOST_FRAMING значением
+     CS_HOST_FRAMING_COBS в классическом кадрировании; устройство, не поддерживающее
+     параметр, продолжает работать по-старому.
+
+     Поиск нулевых байтов при кодировании и копирование блоков при декодировании
+     выполняются memchr/memcpy, которые в стандартной библиотеке векторизованы.
+   */
+#ifndef CSCOBS_H
+#define CSCOBS_H
+
+#include "RUPBaseClass.hpp"
+
+#include <string.h>
+
+//Максимальная длина кодированного сообщения COBS для данных длиной size, включая разделитель
+#define CS_COBS_MAX_LENGTH(size)  ((size) + (size) / 254 + 2)
+
+//Максимальная длина декодированного сообщения, принимаемого CsCobsIn
+#define CS_COBS_IN_SIZE          256
+
+//!
+//! \brief csCobsEncode Кодирование блока данных COBS
+//! \param src          Исходные данные
+//! \param size         Длина исходных данных
+//! \param dst          Приемник, не менее CS_COBS_MAX_LENGTH(size) байтов
+//! \return             Длина кодированных данных, включая разделитель 0
+//!
+int csCobsEncode( const char *src, int size, char *dst );
+
+//!
+//! \brief csCobsDecode Декодирование блока данных COBS
+//! \param src          Кодированные данные без разделителя
+//! \param size         Длина кодированных данных
+//! \param dst          Приемник
+//! \param dstSize      Размер приемника
+//! \return             Длина декодированных данных или -1 при ошибке кадра
+//!
+int csCobsDecode( const char *src, int size, char *dst, int dstSize );
+
+
+
+
+//!
+//! \brief The CsCobsOutT class кодирует сообщение обмена с хостом в кадрировании COBS.
+//! Интерфейс повторяет CsMessageOutT, capacity - максимальная длина данных сообщения.
+//!
+template <int capacity>
+class CsCobsOutT
+  {
+    char    mRaw[capacity + 2];                         //!< Заголовок, данные и КС до кодирования
+    char    mBuffer[CS_COBS_MAX_LENGTH(capacity + 2)];  //!< Кодированное сообщение
+    int16_t mPtr;                                       //!< Номер текущего байта в mRaw
+    int16_t mLength;                                    //!< Длина кодированного сообщения
+  public:
+    CsCobsOutT() : mPtr(0), mLength(0) {}
+
+    void addInt8( int val ) { mRaw[mPtr++] = val; }
+    void addInt16( int val ) { addInt8( val ); addInt8( val >> 8 ); }
+    void addInt32( int val ) { addInt16( val ); addInt16( val >> 16 ); }
+    void addInt64( int64_t val ) { addInt32( static_cast<int>(val) ); addInt32( static_cast<int>(val >> 32) ); }
+    void addFloat( float val ) { addInt32( floatToUInt(val) ); }
+    void addBlock( const char *block, int size ) { memcpy( mRaw + mPtr, block, size ); mPtr += size; }
+
+    //!
+    //! \brief hostBeginQuery Инициализация буфера командой cmd. После инициализации можно добавлять данные
+    //! \param cmd            Формируемая команда
+    //!
+    void hostBeginQuery( char cmd ) { mPtr = 0; addInt8( cmd ); }
+
+    //!
+    //! \brief hostBeginAnswer Инициализация буфера для ответа. После инициализации можно добавлять данные
+    //!
+    void hostBeginAnswer() { mPtr = 0; }
+
+    //!
+    //! \brief hostEnd Завершение формирования: дописывание КС, кодирование COBS и разделитель 0
+    //!
+    void hostEnd()
+      {
+      mRaw[mPtr] = csMessageCrc( mRaw, mPtr );
+      mLength = csCobsEncode( mRaw, mPtr + 1, mBuffer );
+      }
+
+    //!
+    //! \brief length Возвращает длину кодированного сообщения, включая разделитель
+    //! \return       Длина сообщения
+    //!
+    int  length() const { return mLength; }
+
+    //!
+    //! \brief buffer Возвращает кодированное сообщение
+    //! \return       Указатель на начало сообщения
+    //!
+    const char *buffer() const { return mBuffer; }
+  };
+
+using CsCobsOut = CsCobsOutT<64>;
+
+
+
+
+//!
+//! \brief The CsCobsIn class декодирует сообщение обмена с хостом в кадрировании COBS
+//!
+class CsCobsIn
+  {
+    char  mBuffer[CS_COBS_IN_SIZE]; //!< Декодированное сообщение
+    int   mLength;                  //!< Длина декодированного сообщения без КС или -1 при ошибке
+    int   mPtr;                     //!< Номер текущего байта
+  public:
+    //!
+    //! \brief CsCobsIn Декодировать кадр и проверить контрольную сумму
+    //! \param frame    Кодированный кадр без разделителя
+    //! \param size     Длина кадра
+    //! \param query    true - сообщение является запросом (имеет заголовок)
+    //!
+    CsCobsIn( const char *frame, int size, bool query = true );
+
+    //!
+    //! \brief valid Проверить корректность кадра и совпадение контрольной суммы
+    //! \return      true, если сообщение принято без ошибок
+    //!
+    bool  valid() const { return mLength >= 0; }
+
+    //!
+    //! \brief hostCmd Возвращает команду сообщения от хоста
+    //! \return        Команда сообщения
+    //!
+    int   hostCmd() const { return mBuffer[0] & 0xff; }
+
+    //!
+    //! \brief length Возвращает длину сообщения без КС
+    //! \return       Длина сообщения
+    //!
+    int   length() const { return mLength; }
+
+    int     getUInt8() { return mBuffer[mPtr++] & 0xff; }
+    int     getInt8() { return static_cast<int8_t>( getUInt8() ); }
+    int     getUInt16() { int val = getUInt8(); return val | (getUInt8() << 8); }
+    int     getInt16() { return static_cast<int16_t>( getUInt16() ); }
+    int     getInt32() { uint32_t val = getUInt16(); return static_cast<int32_t>( val | (static_cast<uint32_t>( getUInt16() ) << 16) ); }
+    int64_t getInt64() { uint64_t val = static_cast<uint32_t>( getInt32() ); return static_cast<int64_t>( val | (static_cast<uint64_t>( static_cast<uint32_t>( getInt32() ) ) << 32) ); }
+    float   getFloat() { return floatFromUInt( getInt32() ); }
+    void    getBlock( char *dest, int size ) { memcpy( dest, mBuffer + mPtr, size ); mPtr += size; }
+  };
+
+#endif // CSCOBS_H
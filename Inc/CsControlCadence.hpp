@@ -0,0 +1,123 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     CsControlCadence - чередование команд управления с ответом и без ответа
+
+     Во многих циклах нужно только передать воздействие, а состояние двигателя
+     не требуется. Команда CS_CMD_MSG_CONTROL_NA передает воздействие без ответа,
+     и шина освобождается сразу после запроса: время обмена сокращается с
+     запроса и ответа (11 байтов) до одного запроса (5 байтов).
+
+     Для устройства, поддерживающего команду (CS_CAP_CONTROL_NA), полная команда
+     управления с ответом передается один раз за ratio циклов, в остальных
+     циклах - команда без ответа. Фазы устройств сдвинуты на id, поэтому ответы
+     распределяются по циклам равномерно. Устройствам без поддержки всегда
+     передается полная команда.
+
+     Устройствам из маски tagged (режим ответов с метками) команды передаются
+     с байтом метки, номер запроса задает вызывающий (CsTagTracker::issue).
+   */
+#ifndef CSCONTROLCADENCE_H
+#define CSCONTROLCADENCE_H
+
+#include "RUPBaseClass.hpp"
+
+//!
+//! \brief The CsControlCadence class выбирает команду управления для устройства в текущем цикле
+//!
+class CsControlCadence
+  {
+    uint16_t mCapable; //!< Маска устройств, поддерживающих управление без ответа
+    uint16_t mTagged;  //!< Маска устройств в режиме ответов с метками
+    int      mRatio;   //!< Период полной команды управления в циклах
+    uint32_t mCycle;   //!< Номер текущего цикла
+  public:
+    //!
+    //! \brief CsControlCadence Конструктор
+    //! \param ratio            Период полной команды управления в циклах (1 - всегда с ответом)
+    //! \param capable          Маска устройств, поддерживающих управление без ответа
+    //! \param tagged           Маска устройств в режиме ответов с метками (бит id, CS_TAGGED_ALL - все устройства)
+    //!
+    CsControlCadence( int ratio = 1, uint16_t capable = 0, uint16_t tagged = 0 ) :
+      mCapable(capable), mTagged(tagged), mRatio(ratio < 1 ? 1 : ratio), mCycle(0) {}
+
+    //!
+    //! \brief setRatio Установить период полной команды управления
+    //! \param ratio    Период в циклах (1 - всегда с ответом)
+    //!
+    void setRatio( int ratio ) { mRatio = ratio < 1 ? 1 : ratio; }
+
+    //!
+    //! \brief setCapable Установить поддержку управления без ответа устройством (по CsCapabilities::supports)
+    //! \param id         Идентификатор устройства
+    //! \param capable    true - устройство поддерживает CS_CMD_MSG_CONTROL_NA
+    //!
+    void setCapable( int id, bool capable ) { if( capable ) mCapable |= 1 << (id & 0xf); else mCapable &= ~(1 << (id & 0xf)); }
+
+    //!
+    //! \brief setTagged Установить режим ответов с метками для устройства
+    //! \param id        Идентификатор устройства
+    //! \param tagged    true - запросы устройству передаются с байтом метки
+    //!
+    void setTagged( int id, bool tagged ) { if( tagged ) mTagged |= 1 << (id & 0xf); else mTagged &= ~(1 << (id & 0xf)); }
+
+    //!
+    //! \brief nextCycle Перейти к следующему циклу управления
+    //!
+    void nextCycle() { mCycle++; }
+
+    //!
+    //! \brief full Проверить, нужна ли устройству в текущем цикле полная команда управления
+    //! \param id   Идентификатор устройства
+    //! \return     true - команда с ответом, false - без ответа
+    //!
+    bool full( int id ) const { return mRatio == 1 || !(mCapable & (1 << (id & 0xf))) || (mCycle + id) % mRatio == 0; }
+
+    //!
+    //! \brief makeQuery Сформировать команду управления для устройства в текущем цикле
+    //! \param msg       Кодировщик сообщения
+    //! \param id        Идентификатор устройства
+    //! \param value     Значение управления
+    //! \param seq       Номер запроса (0-7) для устройства в режиме ответов с метками
+    //! \return          Код сформированной команды (CS_CMD_MSG_CONTROL или CS_CMD_MSG_CONTROL_NA)
+    //!
+    template <class CsMessageOutTmpl>
+    int  makeQuery( CsMessageOutTmpl &msg, int id, int value, int seq = 0 ) const
+      {
+      int cmd = full( id ) ? CS_CMD_MSG_CONTROL : CS_CMD_MSG_CONTROL_NA;
+      if( csTagLength( mTagged, id ) ) {
+        msg.beginTaggedQuery( cmd, id, seq );
+        msg.addInt16( value );
+        msg.end();
+        }
+      else if( cmd == CS_CMD_MSG_CONTROL )
+        msg.makeQueryControl( id, value );
+      else
+        msg.makeQueryControlNoAnswer( id, value );
+      return cmd;
+      }
+
+    //!
+    //! \brief cycleTime Оценка среднего времени шины на один цикл управления
+    //! \param ids       Маска управляемых устройств
+    //! \param baud      Скорость обмена, бод
+    //! \return          Среднее время передачи, мкс (без учета времени реакции устройств)
+    //!
+    int  cycleTime( uint16_t ids, int baud ) const
+      {
+      int64_t bytes = 0;
+      for( int id = 0; id < CS_DEVICE_COUNT; id++ ) {
+        if( !(ids & (1 << id)) ) continue;
+        int tag       = csTagLength( mTagged, id );
+        int fullBytes = csCmdLengths[CS_CMD_MSG_CONTROL] + csAnswerLengths[CS_CMD_MSG_CONTROL] + 2 * tag;
+        if( mCapable & (1 << id) )
+          //Одна полная команда и ratio-1 команд без ответа за ratio циклов
+          bytes += (fullBytes + static_cast<int64_t>(mRatio - 1) * (csCmdLengths[CS_CMD_MSG_CONTROL_NA] + tag)) * 1000 / mRatio;
+        else
+          bytes += fullBytes * 1000;
+        }
+      return csWireTime( static_cast<int>(bytes / 1000), baud );
+      }
+  };
+
+#endif // CSCONTROLCADENCE_H
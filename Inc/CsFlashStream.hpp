@@ -0,0 +1,141 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     CsFlashStream - заранее закодированный поток прошивки
+
+     При каждой прошивке один и тот же образ кодируется пословно через
+     makeQueryFlash с вычислением КС. Поскольку запросы прошивки зависят только
+     от образа, начального адреса и идентификатора устройства, их можно один раз
+     закодировать в файл готовых сообщений. При прошивке файл отображается в
+     память, и сообщения передаются в порт без кодирования.
+
+     Формат файла (числа от младшего байта к старшему)
+       Заголовок CsFlashHeader
+       Индекс: mFrames смещений сообщений от начала файла, по 4 байта
+       Сообщения: mFrames запросов "Прошивка" длиной mFrameLength байт подряд,
+                  сообщение i записывает слово образа i по адресу mBase + 4*i
+
+     Сообщения имеют одинаковую длину и идут подряд, поэтому несколько сообщений
+     передаются в порт одной записью начиная с frame(i). Индекс позволяет
+     продолжить прошивку с произвольного сообщения после ошибки.
+
+     Образ кодируется параллельно несколькими потоками.
+   */
+#ifndef CSFLASHSTREAM_H
+#define CSFLASHSTREAM_H
+
+#include "RUPBaseClass.hpp"
+
+//Сигнатура файла потока прошивки "ZFLS"
+#define CS_FLASH_STREAM_MAGIC   0x534c465a
+
+//Версия формата файла потока прошивки
+#define CS_FLASH_STREAM_VERSION 1
+
+//!
+//! \brief The CsFlashHeader struct заголовок файла потока прошивки
+//!
+struct CsFlashHeader {
+    uint32_t mMagic;       //!< Сигнатура CS_FLASH_STREAM_MAGIC
+    uint16_t mVersion;     //!< Версия формата CS_FLASH_STREAM_VERSION
+    uint8_t  mId;          //!< Идентификатор прошиваемого устройства
+    uint8_t  mFrameLength; //!< Длина одного сообщения
+    uint32_t mFrames;      //!< Количество сообщений
+    uint32_t mBase;        //!< Адрес первого слова образа
+    uint32_t mIndex;       //!< Смещение индекса от начала файла
+    uint32_t mData;        //!< Смещение первого сообщения от начала файла
+  };
+
+//!
+//! \brief csFlashStreamSize Возвращает размер потока прошивки
+//! \param imageSize         Размер образа в байтах
+//! \return                  Размер потока в байтах
+//!
+int64_t csFlashStreamSize( int64_t imageSize );
+
+//!
+//! \brief csFlashEncode Закодировать образ прошивки в поток готовых сообщений
+//! \param image         Образ прошивки
+//! \param imageSize     Размер образа в байтах, неполное последнее слово дополняется 0xff
+//! \param base          Адрес первого слова образа
+//! \param id            Идентификатор прошиваемого устройства
+//! \param dst           Приемник потока размером csFlashStreamSize( imageSize )
+//! \param threads       Количество потоков кодирования
+//!
+void    csFlashEncode( const char *image, int64_t imageSize, uint32_t base, int id, char *dst, int threads = 1 );
+
+//!
+//! \brief csFlashEncodeFile Закодировать образ прошивки в файл потока
+//! \param path              Путь к создаваемому файлу
+//! \param image             Образ прошивки
+//! \param imageSize         Размер образа в байтах
+//! \param base              Адрес первого слова образа
+//! \param id                Идентификатор прошиваемого устройства
+//! \param threads           Количество потоков кодирования
+//! \return                  true при успешной записи
+//!
+bool    csFlashEncodeFile( const char *path, const char *image, int64_t imageSize, uint32_t base, int id, int threads = 1 );
+
+
+
+//!
+//! \brief The CsFlashStream class отображенный в память файл потока прошивки
+//!
+class CsFlashStream
+  {
+    const char          *mMap;    //!< Отображенный файл
+    int64_t              mSize;   //!< Размер файла
+    const CsFlashHeader *mHeader; //!< Заголовок файла
+    const uint32_t      *mIndex;  //!< Индекс сообщений
+  public:
+    CsFlashStream() : mMap(nullptr), mSize(0), mHeader(nullptr), mIndex(nullptr) {}
+    ~CsFlashStream() { close(); }
+
+    CsFlashStream( const CsFlashStream& ) = delete;
+    CsFlashStream &operator = ( const CsFlashStream& ) = delete;
+
+    //!
+    //! \brief open Отобразить файл потока прошивки в память и проверить заголовок и индекс
+    //! \param path Путь к файлу
+    //! \return     true при успешном открытии
+    //!
+    bool        open( const char *path );
+
+    //!
+    //! \brief close Закрыть файл потока прошивки
+    //!
+    void        close();
+
+    //!
+    //! \brief frames Возвращает количество сообщений потока
+    //! \return       Количество сообщений
+    //!
+    int         frames() const { return mHeader ? static_cast<int>(mHeader->mFrames) : 0; }
+
+    //!
+    //! \brief frameLength Возвращает длину одного сообщения
+    //! \return            Длина сообщения
+    //!
+    int         frameLength() const { return mHeader ? mHeader->mFrameLength : 0; }
+
+    //!
+    //! \brief id Возвращает идентификатор прошиваемого устройства
+    //! \return   Идентификатор устройства
+    //!
+    int         id() const { return mHeader ? mHeader->mId : 0; }
+
+    //!
+    //! \brief base Возвращает адрес первого слова образа
+    //! \return     Адрес
+    //!
+    uint32_t    base() const { return mHeader ? mHeader->mBase : 0; }
+
+    //!
+    //! \brief frame Возвращает сообщение с заданным номером. Последующие сообщения идут сразу за ним
+    //! \param i     Номер сообщения
+    //! \return      Указатель на начало сообщения или nullptr, если номер вне потока
+    //!
+    const char *frame( int i ) const { return i >= 0 && i < frames() ? mMap + mIndex[i] : nullptr; }
+  };
+
+#endif // CSFLASHSTREAM_H
@@ -0,0 +1,91 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     CsHistogram - гистограмма интервалов времени фиксированного размера
+
+     Интервалы распределяются по логарифмическим корзинам: корзина 0 содержит
+     нулевые значения, корзина k (k > 0) - значения от 2^(k-1) до 2^k - 1 мкс,
+     последняя корзина - все значения от 2^(CS_HIST_BINS-2) мкс. Добавление
+     значения - одна инструкция подсчета старших нулей и инкремент, память
+     не выделяется, поэтому гистограмма может вестись в потоке приема.
+   */
+#ifndef CSHISTOGRAM_H
+#define CSHISTOGRAM_H
+
+#include <stdint.h>
+#include <string.h>
+
+//Количество корзин гистограммы (последняя открыта сверху)
+#define CS_HIST_BINS 20
+
+//!
+//! \brief The CsHistogram struct логарифмическая гистограмма интервалов, мкс
+//!
+struct CsHistogram {
+    uint32_t mBins[CS_HIST_BINS]; //!< Количество значений в корзинах
+    uint32_t mCount;              //!< Общее количество значений
+    uint32_t mMax;                //!< Максимальное значение, мкс
+    uint64_t mSum;                //!< Сумма значений, мкс
+
+    CsHistogram() { reset(); }
+
+    //!
+    //! \brief reset Сбросить гистограмму
+    //!
+    void     reset() { memset( mBins, 0, sizeof(mBins) ); mCount = 0; mMax = 0; mSum = 0; }
+
+    //!
+    //! \brief bin   Возвращает номер корзины для значения
+    //! \param value Значение, мкс
+    //! \return      Номер корзины
+    //!
+    static int bin( uint32_t value )
+      {
+      int k = value ? 32 - __builtin_clz( value ) : 0;
+      return k < CS_HIST_BINS ? k : CS_HIST_BINS - 1;
+      }
+
+    //!
+    //! \brief upper Возвращает верхнюю границу корзины
+    //! \param k     Номер корзины
+    //! \return      Наибольшее значение корзины, мкс (для последней - 0xffffffff)
+    //!
+    static uint32_t upper( int k ) { return k == CS_HIST_BINS - 1 ? 0xffffffffu : (1u << k) - 1; }
+
+    //!
+    //! \brief add   Добавить значение
+    //! \param value Значение, мкс
+    //!
+    void     add( uint32_t value )
+      {
+      mBins[bin( value )]++;
+      mCount++;
+      mSum += value;
+      if( value > mMax ) mMax = value;
+      }
+
+    //!
+    //! \brief mean Возвращает среднее значение
+    //! \return     Среднее значение, мкс
+    //!
+    uint32_t mean() const { return mCount ? static_cast<uint32_t>(mSum / mCount) : 0; }
+
+    //!
+    //! \brief percentile Возвращает оценку сверху процентиля
+    //! \param percent    Процент значений от 0 до 100
+    //! \return           Верхняя граница корзины, в которую попадает процентиль, но не более максимума, мкс
+    //!
+    uint32_t percentile( int percent ) const
+      {
+      uint64_t need = (static_cast<uint64_t>(mCount) * percent + 99) / 100;
+      uint64_t sum  = 0;
+      for( int k = 0; k < CS_HIST_BINS; k++ ) {
+        sum += mBins[k];
+        if( sum >= need && sum )
+          return upper( k ) < mMax ? upper( k ) : mMax;
+        }
+      return mMax;
+      }
+  };
+
+#endif // CSHISTOGRAM_H
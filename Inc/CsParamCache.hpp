@@ -0,0 +1,172 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     CsParamCache - сохраняемый между запусками кэш параметров устройств
+
+     При каждом запуске параметры устройств заново читаются по шине, и управление
+     начинается только через несколько секунд. Кэш хранит значения параметров
+     каждого устройства в отображенном в память файле. Запись кэша устройства
+     определяется шиной и идентификатором и действительна, пока совпадают
+     сигнатура устройства (CS_CB_SIGNATURE), версия программы (CS_CB_VERSION)
+     и поколение конфигурации, заданное приложением.
+
+     При запуске для каждого устройства читаются только сигнатура и версия,
+     после чего validate() сообщает, можно ли доверять сохраненным значениям.
+     Если нет - запись устройства очищается, параметры читаются по шине как
+     обычно, с сохранением в кэш через set(), и после чтения всех параметров
+     commit() делает запись действительной. Запись, заполнение которой было
+     прервано (ошибка обмена, завершение программы), при следующем запуске
+     не проходит validate() и заполняется заново.
+
+     Файл отображается с MAP_SHARED, поэтому изменения сохраняются без явной
+     записи; sync() сбрасывает их на диск. На платформах без mmap кэш работает
+     в памяти и не сохраняется.
+   */
+#ifndef CSPARAMCACHE_H
+#define CSPARAMCACHE_H
+
+#include "RUPBaseClass.hpp"
+
+//Количество кэшируемых параметров устройства (индексы 0 - CS_PARAM_CACHE_SIZE-1)
+#define CS_PARAM_CACHE_SIZE    1024
+
+//Сигнатура файла кэша параметров "ZPRC"
+#define CS_PARAM_CACHE_MAGIC   0x4352505a
+
+//Версия формата файла кэша параметров
+#define CS_PARAM_CACHE_VERSION 1
+
+//Состояния записи кэша устройства
+#define CS_PARAM_SLOT_EMPTY    0 //!< Запись пуста
+#define CS_PARAM_SLOT_VALID    1 //!< Значения прочитаны полностью, записи можно доверять
+#define CS_PARAM_SLOT_FILLING  2 //!< Ключ записан, значения читаются по шине
+
+//!
+//! \brief The CsParamSlot struct запись кэша параметров одного устройства
+//!
+struct CsParamSlot {
+    uint32_t mSignature;                          //!< Сигнатура устройства
+    uint32_t mVersion;                            //!< Версия программы устройства
+    uint32_t mGeneration;                         //!< Поколение конфигурации
+    uint32_t mValid;                              //!< Состояние записи CS_PARAM_SLOT_...
+    uint32_t mPresent[CS_PARAM_CACHE_SIZE / 32];  //!< Признаки наличия значений параметров
+    int32_t  mValues[CS_PARAM_CACHE_SIZE];        //!< Значения параметров
+  };
+
+//!
+//! \brief The CsParamFile struct заголовок файла кэша параметров
+//!
+struct CsParamFile {
+    uint32_t    mMagic;   //!< Сигнатура CS_PARAM_CACHE_MAGIC
+    uint32_t    mVersion; //!< Версия формата CS_PARAM_CACHE_VERSION
+    uint32_t    mBuses;   //!< Количество шин
+    uint32_t    mSize;    //!< Размер файла
+  };
+
+
+
+//!
+//! \brief The CsParamCache class кэш параметров устройств, сохраняемый в файле
+//!
+class CsParamCache
+  {
+    char        *mMap;        //!< Отображенный файл или буфер в памяти
+    uint32_t     mSize;       //!< Размер файла
+    bool         mMapped;     //!< true - файл отображен в память
+    int          mBuses;      //!< Количество шин
+    uint32_t     mGeneration; //!< Поколение конфигурации
+    CsParamSlot *mSlots;      //!< Записи устройств [шина][id]
+  public:
+    CsParamCache() : mMap(nullptr), mSize(0), mMapped(false), mBuses(0), mGeneration(0), mSlots(nullptr) {}
+    ~CsParamCache() { close(); }
+
+    CsParamCache( const CsParamCache& ) = delete;
+    CsParamCache &operator = ( const CsParamCache& ) = delete;
+
+    //!
+    //! \brief open       Открыть или создать файл кэша
+    //! \param path       Путь к файлу или nullptr для кэша только в памяти
+    //! \param buses      Количество шин
+    //! \param generation Поколение конфигурации. Записи другого поколения недействительны
+    //! \return           true при успешном открытии
+    //!
+    bool open( const char *path, int buses, uint32_t generation );
+
+    //!
+    //! \brief close Закрыть файл кэша
+    //!
+    void close();
+
+    //!
+    //! \brief sync Сбросить изменения кэша на диск
+    //!
+    void sync();
+
+    //!
+    //! \brief validate  Проверить запись устройства по результатам чтения сигнатуры и версии.
+    //! Если ключ не совпал или заполнение записи не было завершено, запись очищается, получает
+    //! новый ключ и принимает значения через set() до вызова commit()
+    //! \param bus       Номер шины
+    //! \param id        Идентификатор устройства
+    //! \param signature Прочитанная сигнатура устройства (CS_CB_SIGNATURE)
+    //! \param version   Прочитанная версия программы (CS_CB_VERSION)
+    //! \return          true, если сохраненным значениям можно доверять
+    //!
+    bool validate( int bus, int id, uint32_t signature, uint32_t version );
+
+    //!
+    //! \brief commit Завершить заполнение записи устройства после чтения всех параметров.
+    //! Только после этого записи можно доверять при следующих запусках
+    //! \param bus    Номер шины
+    //! \param id     Идентификатор устройства
+    //!
+    void commit( int bus, int id );
+
+    //!
+    //! \brief invalidate Очистить запись устройства
+    //! \param bus        Номер шины
+    //! \param id         Идентификатор устройства
+    //!
+    void invalidate( int bus, int id );
+
+    //!
+    //! \brief get   Получить сохраненное значение параметра
+    //! \param bus   Номер шины
+    //! \param id    Идентификатор устройства
+    //! \param index Индекс параметра
+    //! \param value Приемник значения
+    //! \return      true, если значение есть в кэше
+    //!
+    bool get( int bus, int id, int index, int32_t &value ) const
+      {
+      const CsParamSlot *slot = find( bus, id, index );
+      if( slot == nullptr || slot->mValid != CS_PARAM_SLOT_VALID || !(slot->mPresent[index >> 5] & (1u << (index & 31))) ) return false;
+      value = slot->mValues[index];
+      return true;
+      }
+
+    //!
+    //! \brief set   Сохранить значение параметра. Значение сохраняется только в запись, прошедшую validate()
+    //! (при заполнении - до вызова commit())
+    //! \param bus   Номер шины
+    //! \param id    Идентификатор устройства
+    //! \param index Индекс параметра
+    //! \param value Значение параметра
+    //!
+    void set( int bus, int id, int index, int32_t value )
+      {
+      CsParamSlot *slot = const_cast<CsParamSlot*>( find( bus, id, index ) );
+      if( slot == nullptr || slot->mValid == CS_PARAM_SLOT_EMPTY ) return;
+      slot->mValues[index] = value;
+      slot->mPresent[index >> 5] |= 1u << (index & 31);
+      }
+
+  private:
+    const CsParamSlot *find( int bus, int id, int index ) const
+      {
+      if( mSlots == nullptr || bus < 0 || bus >= mBuses || index < 0 || index >= CS_PARAM_CACHE_SIZE ) return nullptr;
+      return mSlots + bus * CS_DEVICE_COUNT + (id & 0xf);
+      }
+  };
+
+#endif // CSPARAMCACHE_H
@@ -0,0 +1,82 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     CsPlacement - размещение потоков обмена с шинами с учетом топологии NUMA
+
+     На многопроцессорных хостах прерывания последовательного порта, поток обмена
+     с шиной и поток управления нередко оказываются на разных узлах NUMA, из-за чего
+     каждое сообщение вызывает межузловой трафик кэша. Для устранения этого поток
+     обмена с шиной привязывается к процессорам того узла, на котором обрабатывается
+     прерывание адаптера шины.
+
+     Прерывание определяется по sysfs: ближайшее родительское устройство порта,
+     имеющее прерывания (msi_irqs или irq, как правило PCI-контроллер USB или UART).
+     Узел прерывания берется из /proc/irq/<n>/node, а если он не задан - по первому
+     процессору из /proc/irq/<n>/effective_affinity_list (smp_affinity_list).
+     Если прерывание определить не удалось (например, нет прав), используется
+     numa_node ближайшего родительского устройства.
+
+     Память выделяется ядром Linux по первому обращению (first touch), поэтому
+     кольцевые буферы и пулы сообщений шины нужно создавать и заполнять уже
+     из привязанного потока - тогда они окажутся на том же узле.
+
+     Реализация доступна только для Linux, на других платформах функции возвращают
+     признак неудачи.
+   */
+#ifndef CSPLACEMENT_H
+#define CSPLACEMENT_H
+
+//!
+//! \brief The CsBusPlacement struct размещение потока обмена с одной шиной
+//!
+struct CsBusPlacement {
+    int mIrq;  //!< Прерывание адаптера шины или -1, если не определено
+    int mNode; //!< Узел NUMA прерывания (или адаптера) шины или -1, если не определен
+    int mCpu;  //!< Процессор, на котором выполняется поток обмена, или -1
+
+    CsBusPlacement() : mIrq(-1), mNode(-1), mCpu(-1) {}
+  };
+
+//!
+//! \brief csTtyIrq Определить прерывание адаптера последовательного порта
+//! \param tty      Имя порта без /dev/, например ttyUSB0
+//! \return         Номер прерывания или -1, если не определено
+//!
+int  csTtyIrq( const char *tty );
+
+//!
+//! \brief csIrqNode Определить узел NUMA, на котором обрабатывается прерывание
+//! \param irq       Номер прерывания
+//! \return          Номер узла NUMA или -1, если не определен
+//!
+int  csIrqNode( int irq );
+
+//!
+//! \brief csTtyNumaNode Определить узел NUMA, к которому подключен адаптер последовательного порта
+//! \param tty           Имя порта без /dev/, например ttyUSB0
+//! \return              Номер узла NUMA или -1, если не определен
+//!
+int  csTtyNumaNode( const char *tty );
+
+//!
+//! \brief csNodeCpuCount Возвращает количество процессоров узла NUMA
+//! \param node           Номер узла NUMA
+//! \return               Количество процессоров или 0, если узел не найден
+//!
+int  csNodeCpuCount( int node );
+
+//!
+//! \brief csBindToNode Привязать текущий поток к процессорам узла NUMA
+//! \param node         Номер узла NUMA
+//! \return             true при успешной привязке
+//!
+bool csBindToNode( int node );
+
+//!
+//! \brief csPlaceBusThread Привязать текущий поток к узлу NUMA прерывания адаптера шины
+//! \param tty              Имя порта без /dev/, например ttyUSB0
+//! \return                 Размещение потока (прерывание, узел и текущий процессор)
+//!
+CsBusPlacement csPlaceBusThread( const char *tty );
+
+#endif // CSPLACEMENT_H
@@ -0,0 +1,91 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     CsRetransmit - повтор запроса в пределах цикла при ошибке контрольной суммы
+
+     Если ответ не прошел проверку CsMessageIn::checkCrc, то воздействие или состояние
+     устройства теряется до следующего цикла. На зашумленных шинах это заметно снижает
+     частоту управления. Политика повтора оценивает по модели времени передачи
+     (или по адаптивному времени ожидания CsRttEstimator), поместится ли повтор
+     данного запроса в оставшийся запас времени текущего цикла, и если да - разрешает
+     немедленный повтор. Таким образом цикл не удлиняется.
+
+     Ведется учет восстановленных повтором и потерянных запросов, в том числе
+     повторов, оставшихся без ответа.
+   */
+#ifndef CSRETRANSMIT_H
+#define CSRETRANSMIT_H
+
+#include "CsRttEstimator.hpp"
+
+//!
+//! \brief The CsRetransmitPolicy class принимает решение о повторе запроса при ошибке КС ответа
+//!
+class CsRetransmitPolicy
+  {
+    int      mBaud;       //!< Скорость обмена на шине, бод
+    int      mMaxRetries; //!< Максимальное количество повторов одного запроса
+    uint32_t mRetries;    //!< Количество выполненных повторов
+    uint32_t mRecovered;  //!< Количество запросов, ответ на которые получен после повтора
+    uint32_t mLost;       //!< Количество запросов, ответ на которые потерян
+  public:
+    //!
+    //! \brief CsRetransmitPolicy Конструктор политики повтора
+    //! \param baud               Скорость обмена на шине, бод
+    //! \param maxRetries         Максимальное количество повторов одного запроса в цикле
+    //!
+    CsRetransmitPolicy( int baud, int maxRetries = 1 ) :
+      mBaud(baud), mMaxRetries(maxRetries), mRetries(0), mRecovered(0), mLost(0) {}
+
+    //!
+    //! \brief cost Возвращает время, необходимое на повтор запроса
+    //! \param cmd  Команда запроса
+    //! \param rtt  Оценка времени обмена с устройством или nullptr
+    //! \return     Время повтора, мкс
+    //!
+    int  cost( int cmd, const CsRttEstimator *rtt = nullptr ) const;
+
+    //!
+    //! \brief crcError Обработать ответ с ошибкой КС
+    //! \param cmd      Команда запроса
+    //! \param attempt  Номер попытки, на которую получен ответ (0 - исходный запрос)
+    //! \param slack    Оставшийся запас времени текущего цикла, мкс
+    //! \param rtt      Оценка времени обмена с устройством или nullptr
+    //! \return         true, если запрос нужно немедленно повторить, false - ответ потерян
+    //!
+    bool crcError( int cmd, int attempt, int slack, const CsRttEstimator *rtt = nullptr );
+
+    //!
+    //! \brief answered Учесть ответ с правильной КС
+    //! \param attempt  Номер попытки, на которую получен ответ (0 - исходный запрос)
+    //!
+    void answered( int attempt ) { if( attempt ) mRecovered++; }
+
+    //!
+    //! \brief timeout Учесть отсутствие ответа за время ожидания. Повтор, на который
+    //! не получен ответ, означает потерю запроса. Отсутствие ответа на исходный запрос
+    //! не является ошибкой КС и учитывается в CsRttEstimator::miss
+    //! \param attempt Номер попытки, ответ на которую не получен (0 - исходный запрос)
+    //!
+    void timeout( int attempt ) { if( attempt ) mLost++; }
+
+    //!
+    //! \brief retries Возвращает количество выполненных повторов
+    //! \return        Количество повторов
+    //!
+    uint32_t retries() const { return mRetries; }
+
+    //!
+    //! \brief recovered Возвращает количество запросов, восстановленных повтором
+    //! \return          Количество запросов
+    //!
+    uint32_t recovered() const { return mRecovered; }
+
+    //!
+    //! \brief lost Возвращает количество потерянных запросов
+    //! \return     Количество запросов
+    //!
+    uint32_t lost() const { return mLost; }
+  };
+
+#endif // CSRETRANSMIT_H
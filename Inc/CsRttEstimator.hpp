@@ -0,0 +1,141 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     CsRttEstimator - адаптивное время ожидания ответа устройства
+
+     Фиксированное время ожидания ответа либо слишком велико (теряется время цикла
+     на отсутствующих или медленных устройствах), либо слишком мало (ложные повторы
+     на низких скоростях). Поэтому для каждой пары (шина, устройство) время ожидания
+     вычисляется по измерениям, как в TCP (RFC 6298).
+
+     Время передачи запроса и ответа зависит от команды (запись и программирование
+     на низкой скорости много длиннее управления) и известно по модели (csExchangeTime),
+     поэтому сглаживается только время реакции устройства R = RTT - csExchangeTime(cmd):
+       SRTT   = 7/8 SRTT + 1/8 R
+       RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - R|
+       RTO    = csExchangeTime(cmd) + SRTT + max(G, 4 RTTVAR)
+     До первого измерения вместо сглаженной реакции используется запас CS_RTT_TURNAROUND.
+
+     Устройство, не ответившее подряд CS_RTT_ABSENT_MISSES раз, считается отсутствующим:
+     его опрос выполняется лишь раз в несколько циклов и с минимальным временем ожидания,
+     чтобы не тратить время цикла.
+
+     Измерения для повторно отправленных запросов учитывать нельзя (алгоритм Карна),
+     так как неизвестно, на какой из запросов пришел ответ.
+   */
+#ifndef CSRTTESTIMATOR_H
+#define CSRTTESTIMATOR_H
+
+#include "RUPBaseClass.hpp"
+
+#define CS_RTT_GRANULARITY        20 //!< Минимальная добавка к SRTT, мкс
+#define CS_RTT_TURNAROUND        100 //!< Запас на реакцию устройства до первого измерения, мкс
+#define CS_RTT_MAX             20000 //!< Максимальное время ожидания сверх времени передачи, мкс
+#define CS_RTT_ABSENT_MISSES       3 //!< Количество пропусков подряд, после которого устройство отсутствует
+#define CS_RTT_PROBE_PERIOD      100 //!< Период опроса отсутствующего устройства, циклов
+
+
+//!
+//! \brief The CsRttEstimator class оценивает время обмена с одним устройством
+//! и вычисляет время ожидания его ответа.
+//!
+class CsRttEstimator
+  {
+    int32_t mSrtt8;    //!< Сглаженное время реакции, умноженное на 8, мкс
+    int32_t mRttvar4;  //!< Сглаженное отклонение времени реакции, умноженное на 4, мкс
+    int32_t mBaud;     //!< Скорость обмена, бод, или 0 если не задана
+    bool    mMeasured; //!< Признак наличия измерений
+    int16_t mMisses;   //!< Количество пропусков ответа подряд
+    int16_t mSkip;     //!< Количество пропущенных циклов опроса отсутствующего устройства
+  public:
+    CsRttEstimator() : mSrtt8(0), mRttvar4(0), mBaud(0), mMeasured(false), mMisses(0), mSkip(0) {}
+
+    //!
+    //! \brief reset Сбросить оценку
+    //! \param baud  Скорость обмена, бод
+    //!
+    void reset( int baud );
+
+    //!
+    //! \brief sample Учесть измеренное время обмена
+    //! \param cmd    Команда запроса
+    //! \param rtt    Время от начала передачи запроса до приема ответа, мкс
+    //!
+    void sample( int cmd, int rtt );
+
+    //!
+    //! \brief miss Учесть отсутствие ответа за время ожидания
+    //!
+    void miss();
+
+    //!
+    //! \brief timeout Возвращает время ожидания ответа
+    //! \param cmd     Команда запроса
+    //! \return        Время ожидания от начала передачи запроса, мкс
+    //!
+    int  timeout( int cmd ) const;
+
+    //!
+    //! \brief absent Проверить, считается ли устройство отсутствующим
+    //! \return       true, если устройство не ответило CS_RTT_ABSENT_MISSES раз подряд
+    //!
+    bool absent() const { return mMisses >= CS_RTT_ABSENT_MISSES; }
+
+    //!
+    //! \brief poll Вызывается один раз за цикл перед опросом устройства
+    //! \return     true, если устройство нужно опрашивать в этом цикле
+    //!
+    bool poll();
+
+    //!
+    //! \brief measured Проверить наличие измерений
+    //! \return         true, если учтено хотя бы одно измерение
+    //!
+    bool measured() const { return mMeasured; }
+
+    //!
+    //! \brief srtt Возвращает сглаженное время реакции устройства
+    //! \return     Время реакции, мкс, или 0, если измерений еще не было
+    //!
+    int  srtt() const { return mSrtt8 >> 3; }
+
+    //!
+    //! \brief rttvar Возвращает сглаженное отклонение времени реакции
+    //! \return       Отклонение, мкс
+    //!
+    int  rttvar() const { return mRttvar4 >> 2; }
+  };
+
+
+
+
+//!
+//! \brief The CsRttTable class хранит оценки времени обмена для всех устройств на buses шинах
+//!
+template <int buses>
+class CsRttTable
+  {
+    CsRttEstimator mDevices[buses][CS_DEVICE_COUNT]; //!< Оценки по шинам и идентификаторам
+  public:
+    //!
+    //! \brief reset Сбросить оценки всех устройств шины
+    //! \param bus   Номер шины
+    //! \param baud  Скорость обмена на шине, бод
+    //!
+    void reset( int bus, int baud )
+      {
+      for( int id = 0; id < CS_DEVICE_COUNT; id++ )
+        mDevices[bus][id].reset( baud );
+      }
+
+    //!
+    //! \brief at  Возвращает оценку для устройства
+    //! \param bus Номер шины
+    //! \param id  Идентификатор устройства
+    //! \return    Оценка времени обмена
+    //!
+    CsRttEstimator       &at( int bus, int id ) { return mDevices[bus][id & 0xf]; }
+    const CsRttEstimator &at( int bus, int id ) const { return mDevices[bus][id & 0xf]; }
+  };
+
+#endif // CSRTTESTIMATOR_H
@@ -0,0 +1,101 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     CsSignatureSweep - проверка устройств шины чтением сигнатуры
+
+     После повторного открытия порта нужно убедиться, что на шине те же
+     устройства, прежде чем возобновлять управление. Для каждого ожидаемого
+     устройства читается CS_CB_SIGNATURE.
+
+     Шина полудуплексная: ответы нескольких устройств на запросы, переданные
+     одной записью, столкнулись бы в линии. Поэтому в любом режиме к шине
+     передается один запрос, следующий - после ответа или тайм-аута, и проверка
+     присутствующего устройства занимает время обмена csExchangeTime с учетом
+     байта метки. Отсутствующее устройство отмечается по тайм-ауту.
+     Устройствам в режиме ответов с метками (маска tagged) запрос передается
+     с меткой, и ответ принимается, только если метка указывает на опрашиваемое
+     устройство.
+
+     Байты эха собственных запросов (полудуплексный адаптер) пропускаются
+     по заголовку.
+   */
+#ifndef CSSIGNATURESWEEP_H
+#define CSSIGNATURESWEEP_H
+
+#include "RUPBaseClass.hpp"
+
+//!
+//! \brief The CsSignatureSweep class проверка присутствия устройств чтением сигнатуры
+//!
+class CsSignatureSweep
+  {
+    uint16_t mIds;                          //!< Маска проверяемых устройств
+    uint16_t mSeen;                         //!< Маска ответивших устройств
+    uint16_t mSent;                         //!< Маска устройств, которым переданы запросы
+    uint16_t mDone;                         //!< Маска устройств, опрос которых завершен
+    uint16_t mTagged;                       //!< Маска устройств в режиме ответов с метками
+    int      mCurrent;                      //!< Опрашиваемое устройство или -1
+    uint32_t mSignature[CS_DEVICE_COUNT];   //!< Прочитанные сигнатуры
+    char     mAnswer[16];                   //!< Накопитель ответа
+    int      mLength;                       //!< Количество байтов в накопителе
+    int      mSkip;                         //!< Количество пропускаемых байтов эха запроса
+  public:
+    //!
+    //! \brief CsSignatureSweep Конструктор проверки
+    //! \param ids              Маска проверяемых устройств (бит id)
+    //! \param tagged           Маска устройств в режиме ответов с метками (бит id, CS_TAGGED_ALL - все устройства)
+    //!
+    CsSignatureSweep( uint16_t ids, uint16_t tagged = 0 );
+
+    //!
+    //! \brief makeQueries Сформировать очередной запрос. Пока ожидается ответ на переданный
+    //! запрос, новый не формируется
+    //! \param dst         Буфер-приемник
+    //! \param capacity    Размер буфера
+    //! \return            Количество байтов запроса или 0, если передавать нечего
+    //!
+    int      makeQueries( char *dst, int capacity );
+
+    //!
+    //! \brief feed Обработать принятые байты
+    //! \param data Принятые байты
+    //! \param size Количество байтов
+    //!
+    void     feed( const char *data, int size );
+
+    //!
+    //! \brief timeout Сообщить об истечении времени ожидания ответа на переданный запрос
+    //!
+    void     timeout();
+
+    //!
+    //! \brief done Проверить завершение проверки
+    //! \return     true, если опрос всех устройств завершен
+    //!
+    bool     done() const { return mDone == mIds; }
+
+    //!
+    //! \brief present Проверить, ответило ли устройство
+    //! \param id      Идентификатор устройства
+    //! \return        true, если устройство ответило
+    //!
+    bool     present( int id ) const { return mSeen & (1 << (id & 0xf)); }
+
+    //!
+    //! \brief signature Возвращает прочитанную сигнатуру устройства
+    //! \param id        Идентификатор устройства
+    //! \return          Сигнатура или 0, если устройство не ответило
+    //!
+    uint32_t signature( int id ) const { return mSignature[id & 0xf]; }
+
+    //!
+    //! \brief missing Возвращает маску не ответивших устройств
+    //! \return        Маска устройств
+    //!
+    uint16_t missing() const { return mIds & ~mSeen; }
+
+  private:
+    void     accept( int id );
+  };
+
+#endif // CSSIGNATURESWEEP_H
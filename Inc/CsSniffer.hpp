@@ -0,0 +1,146 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     CsSniffer - пассивный анализатор обмена на шине
+
+     При отладке на объекте шина прослушивается вторым адаптером, который видит
+     запросы хоста и ответы устройств вперемешку, без признака направления.
+     Направление восстанавливается по протоколу:
+       - запрос начинается с заголовка (старший бит 0), его длина берется из
+         CS_CMD_LENGHTS, запросы выделяются CsFrameScanner;
+       - ответ не имеет заголовка и следует сразу за запросом, его длина берется
+         из CS_ANSWER_LENGHTS по команде запроса;
+       - к устройствам в режиме с метками (маска tagged) несколько запросов могут
+         ожидать ответа одновременно, ответ начинается с метки и сопоставляется
+         с запросом по ней; ответ устройства без меток следует сразу за запросом;
+       - на широковещательную запись параметра (id = 15) ответа нет.
+     Если до конца ожидаемого ответа встретился заголовок, ответ считается пропущенным.
+
+     Время приема каждого байта восстанавливается по времени поступления блока
+     данных и скорости обмена. Задержка ответа устройства - время от окончания
+     запроса до начала ответа в линии.
+
+     Разбор выполняется без выделения памяти, на каждый байт приходится одно
+     копирование в кольцевой буфер и проверка старшего бита, поэтому одного ядра
+     достаточно для самой высокой скорости обмена.
+   */
+#ifndef CSSNIFFER_H
+#define CSSNIFFER_H
+
+#include "RUPBaseClass.hpp"
+
+//Размер кольцевого буфера анализатора (степень 2)
+#define CS_SNIFF_RING 1024
+
+//!
+//! \brief The CsSniffRecord struct запрос и ответ на него, выделенные анализатором
+//!
+struct CsSniffRecord {
+    CsFrame  mQuery;      //!< Запрос
+    CsFrame  mAnswer;     //!< Ответ, длина 0 если ответ пропущен, принят с ошибкой или не предусмотрен
+    uint32_t mTime;       //!< Время окончания запроса, мкс
+    int32_t  mLatency;    //!< Задержка ответа устройства (в том числе ответа с ошибкой), мкс, или -1 если ответа нет
+    int32_t  mErrorBytes; //!< Количество байтов ответа с ошибкой КС или прерванного ответа, иначе 0
+  };
+
+//!
+//! \brief CsSniffFn Функция обработки выделенной пары запрос-ответ
+//! \param context   Контекст, переданный при создании анализатора
+//! \param record    Запрос и ответ. Данные действительны только во время вызова
+//!
+typedef void (*CsSniffFn)( void *context, const CsSniffRecord &record );
+
+//!
+//! \brief The CsSniffStat struct статистика обмена с одним устройством
+//!
+struct CsSniffStat {
+    uint32_t mQueries;    //!< Количество запросов
+    uint32_t mAnswers;    //!< Количество ответов
+    uint32_t mMissing;    //!< Количество пропущенных ответов
+    uint32_t mCrcErrors;  //!< Количество ответов с ошибкой КС
+    uint32_t mLatencyMin; //!< Минимальная задержка ответа, мкс
+    uint32_t mLatencyMax; //!< Максимальная задержка ответа, мкс
+    uint64_t mLatencySum; //!< Сумма задержек ответов, мкс
+
+    CsSniffStat() : mQueries(0), mAnswers(0), mMissing(0), mCrcErrors(0), mLatencyMin(0xffffffffu), mLatencyMax(0), mLatencySum(0) {}
+
+    //!
+    //! \brief latency Возвращает среднюю задержку ответа
+    //! \return        Средняя задержка, мкс
+    //!
+    uint32_t latency() const { return mAnswers ? static_cast<uint32_t>(mLatencySum / mAnswers) : 0; }
+  };
+
+
+//!
+//! \brief The CsSniffer class выделяет из прослушиваемого потока запросы и ответы,
+//! сопоставляет их и накапливает статистику задержек по устройствам
+//!
+class CsSniffer
+  {
+    //Запрос, ожидающий ответа
+    struct Pending {
+      char     mBytes[CS_CMD_FLASH_LENGTH + 2]; //!< Копия запроса
+      int8_t   mLength;                         //!< Длина запроса или 0, если ответ не ожидается
+      uint32_t mTime;                           //!< Время окончания запроса, мкс
+      };
+
+    char        mRing[CS_SNIFF_RING];                      //!< Кольцевой буфер принятых байтов
+    uint32_t    mTimes[CS_SNIFF_RING];                     //!< Время приема каждого байта, мкс
+    int         mHead;                                     //!< Индекс первого неразобранного байта
+    int         mAvail;                                    //!< Количество неразобранных байтов
+    uint16_t    mTagged;                                   //!< Маска устройств в режиме ответов с метками (бит id)
+    uint32_t    mByteTime;                                 //!< Время передачи байта, нс, или 0 если скорость неизвестна
+    Pending     mPending[CS_DEVICE_COUNT][CS_TAG_SEQ_COUNT]; //!< Запросы, ожидающие ответа, по id и номеру запроса
+    int         mWaitId;                                   //!< Устройство без меток, от которого ожидается ответ, или -1
+    uint32_t    mFrameErrors;                              //!< Количество отброшенных запросов
+    CsSniffFn   mHandler;                                  //!< Функция обработки пар запрос-ответ
+    void       *mContext;                                  //!< Контекст функции обработки
+    CsSniffStat mStat[CS_DEVICE_COUNT];                    //!< Статистика по устройствам
+  public:
+    //!
+    //! \brief CsSniffer Конструктор анализатора
+    //! \param baud      Скорость обмена, бод, или 0 если неизвестна
+    //! \param tagged    Маска устройств в режиме ответов с метками (бит id, CS_TAGGED_ALL - все устройства)
+    //! \param handler   Функция обработки пар запрос-ответ или nullptr
+    //! \param context   Контекст функции обработки
+    //!
+    CsSniffer( int baud = 0, uint16_t tagged = 0, CsSniffFn handler = nullptr, void *context = nullptr );
+
+    //!
+    //! \brief feed Обработать принятый блок данных
+    //! \param data Принятые байты
+    //! \param size Количество байтов
+    //! \param time Время приема последнего байта блока, мкс
+    //!
+    void feed( const char *data, int size, uint32_t time );
+
+    //!
+    //! \brief stat Возвращает статистику обмена с устройством
+    //! \param id   Идентификатор устройства
+    //! \return     Статистика
+    //!
+    const CsSniffStat &stat( int id ) const { return mStat[id & 0xf]; }
+
+    //!
+    //! \brief frameErrors Возвращает количество отброшенных запросов (ошибка КС или прерванный запрос)
+    //! \return            Количество ошибок
+    //!
+    uint32_t frameErrors() const { return mFrameErrors; }
+
+    //!
+    //! \brief reset Сбросить ожидающие запросы и статистику
+    //!
+    void reset();
+
+  private:
+    char at( int index ) const { return mRing[(mHead + index) & (CS_SNIFF_RING - 1)]; }
+    int  tag( int id ) const { return csTagLength( mTagged, id ); }
+    void skip( int count ) { mHead = (mHead + count) & (CS_SNIFF_RING - 1); mAvail -= count; }
+    bool step();
+    bool query();
+    bool answer( Pending &pending, int id );
+    void report( Pending &pending, const CsFrame &answer, int32_t latency, int errorBytes = 0 );
+  };
+
+#endif // CSSNIFFER_H
@@ -0,0 +1,197 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     CsStateStore - хранилище состояния всех устройств на всех шинах
+
+     Закон управления каждый цикл обрабатывает все сочленения, поэтому состояние
+     устройств хранится не в объектах отдельных шин, а в общих массивах (структура
+     массивов): угол, момент, значения информации, время обновления и признаки
+     обновления для каждой пары (шина, устройство). Угол и момент приходят в ответе
+     на команду "Управление", значения информации - в ответе на "Получить информацию",
+     поэтому признак обновления ведется отдельно для каждой группы полей. Ячейка устройства имеет
+     индекс bus * CS_DEVICE_COUNT + id. Массивы выровнены на строку кэша и дополнены
+     до кратного CS_STATE_ALIGN размера, что позволяет обрабатывать их векторными
+     командами без хвостовых проверок.
+
+     Хранилище имеет два банка. Разборщики ответов обновляют задний банк на месте,
+     в конце цикла publish() делает его передним. Читающая сторона работает только
+     с передним банком и по номеру публикации (как в seqlock) проверяет, что за время
+     чтения банк не начал перезаписываться, поэтому никогда не видит наполовину
+     обновленный цикл.
+
+     Гонка данных допущена намеренно: publish() перезаписывает бывший передний банк
+     обычным memcpy, пока читающая сторона может копировать его обычным memcpy.
+     По модели памяти C++ это гонка (неопределенное поведение), как и в любом seqlock
+     на обычных переменных. Порядок обеспечивают барьеры: release-барьер в publish()
+     между сменой номера и перезаписью банка и acquire-барьер в endRead() между
+     чтением данных и повторной проверкой номера. Результат чтения, пересекшегося
+     с перезаписью, отбрасывается по несовпадению номера и не используется.
+     Копирование через атомарные операции над каждым словом исключило бы гонку
+     формально, но лишило бы копирование банка векторизации в каждом цикле.
+     Проверка ThreadSanitizer сообщает об этой гонке, ее нужно подавить.
+   */
+#ifndef CSSTATESTORE_H
+#define CSSTATESTORE_H
+
+#include "RUPBaseClass.hpp"
+
+#include <atomic>
+#include <string.h>
+
+//Выравнивание массивов состояния, байт (строка кэша)
+#define CS_STATE_ALIGN 64
+
+//!
+//! \brief The CsStateBank struct один банк состояния устройств в виде структуры массивов
+//!
+template <int slots>
+struct CsStateBank {
+    alignas(CS_STATE_ALIGN) int16_t mAngle[slots];        //!< Текущий угол
+    alignas(CS_STATE_ALIGN) int16_t mMoment[slots];       //!< Текущий момент
+    alignas(CS_STATE_ALIGN) int16_t mInfo0[slots];        //!< Значение информации 0
+    alignas(CS_STATE_ALIGN) int16_t mInfo1[slots];        //!< Значение информации 1
+    alignas(CS_STATE_ALIGN) int16_t mInfo2[slots];        //!< Значение информации 2
+    alignas(CS_STATE_ALIGN) int64_t mTime[slots];         //!< Время последнего обновления, мкс
+    alignas(CS_STATE_ALIGN) uint8_t mValidControl[slots]; //!< Признак обновления угла и момента в данном цикле
+    alignas(CS_STATE_ALIGN) uint8_t mValidInfo[slots];    //!< Признак обновления значений информации в данном цикле
+  };
+
+
+
+
+//!
+//! \brief The CsStateStore class хранит последнее состояние всех устройств на buses шинах
+//! с двойной буферизацией
+//!
+template <int buses>
+class CsStateStore
+  {
+  public:
+    //Количество ячеек, дополненное до кратного выравниванию для 16-битных значений
+    static constexpr int slots = (buses * CS_DEVICE_COUNT + CS_STATE_ALIGN / 2 - 1) / (CS_STATE_ALIGN / 2) * (CS_STATE_ALIGN / 2);
+
+    using Bank = CsStateBank<slots>;
+
+  private:
+    Bank                  mBanks[2]; //!< Банки состояния
+    std::atomic<uint32_t> mSeq;      //!< Номер публикации, младший бит - индекс переднего банка
+    Bank                 *mBack;     //!< Задний банк, обновляемый разборщиками
+
+  public:
+    CsStateStore() : mSeq(0), mBack(&mBanks[1]) { memset( mBanks, 0, sizeof(mBanks) ); }
+
+    //!
+    //! \brief slot Возвращает индекс ячейки устройства
+    //! \param bus  Номер шины
+    //! \param id   Идентификатор устройства
+    //! \return     Индекс ячейки в массивах
+    //!
+    static int slot( int bus, int id ) { return bus * CS_DEVICE_COUNT + (id & 0xf); }
+
+    //!
+    //! \brief setControl Обновить состояние по ответу на команду "Управление"
+    //! \param bus        Номер шины
+    //! \param id         Идентификатор устройства
+    //! \param angle      Текущий угол
+    //! \param moment     Текущий момент
+    //! \param time       Время приема ответа, мкс
+    //!
+    void setControl( int bus, int id, int angle, int moment, int64_t time )
+      {
+      int i = slot( bus, id );
+      mBack->mAngle[i]        = angle;
+      mBack->mMoment[i]       = moment;
+      mBack->mTime[i]         = time;
+      mBack->mValidControl[i] = 1;
+      }
+
+    //!
+    //! \brief setControl Обновить состояние устройств шины по пакетно декодированным ответам
+    //! \param bus        Номер шины
+    //! \param ids        Идентификаторы устройств
+    //! \param count      Количество ответов
+    //! \param angles     Массив текущих углов
+    //! \param moments    Массив текущих моментов
+    //! \param time       Время приема ответов, мкс
+    //!
+    void setControl( int bus, const uint8_t *ids, int count, const int16_t *angles, const int16_t *moments, int64_t time )
+      {
+      for( int k = 0; k < count; k++ )
+        setControl( bus, ids[k], angles[k], moments[k], time );
+      }
+
+    //!
+    //! \brief setInfo Обновить состояние по ответу на команду "Получить информацию"
+    //! \param bus     Номер шины
+    //! \param id      Идентификатор устройства
+    //! \param val0    Значение 0
+    //! \param val1    Значение 1
+    //! \param val2    Значение 2
+    //! \param time    Время приема ответа, мкс
+    //!
+    void setInfo( int bus, int id, int val0, int val1, int val2, int64_t time )
+      {
+      int i = slot( bus, id );
+      mBack->mInfo0[i]     = val0;
+      mBack->mInfo1[i]     = val1;
+      mBack->mInfo2[i]     = val2;
+      mBack->mTime[i]      = time;
+      mBack->mValidInfo[i] = 1;
+      }
+
+    //!
+    //! \brief back Возвращает задний банк для непосредственного обновления разборщиками
+    //! \return     Задний банк
+    //!
+    Bank &back() { return *mBack; }
+
+    //!
+    //! \brief publish Завершить цикл: сделать задний банк передним. Новый задний банк
+    //! получает копию состояния со сброшенными признаками обновления
+    //!
+    void publish()
+      {
+      uint32_t seq = mSeq.load( std::memory_order_relaxed ) + 1;
+      mSeq.store( seq, std::memory_order_release );
+      Bank *front = mBack;
+      mBack = &mBanks[(seq & 1) ^ 1];
+      //Перезапись бывшего переднего банка может пересечься с его чтением (намеренная гонка,
+      //см. описание): барьер упорядочивает смену номера до записи данных
+      std::atomic_thread_fence( std::memory_order_release );
+      memcpy( mBack, front, sizeof(Bank) );
+      memset( mBack->mValidControl, 0, sizeof(mBack->mValidControl) );
+      memset( mBack->mValidInfo, 0, sizeof(mBack->mValidInfo) );
+      }
+
+    //!
+    //! \brief beginRead Начать чтение переднего банка
+    //! \param seq       Номер публикации, который нужно передать в endRead
+    //! \return          Передний банк
+    //!
+    const Bank &beginRead( uint32_t &seq ) const
+      {
+      seq = mSeq.load( std::memory_order_acquire );
+      return mBanks[seq & 1];
+      }
+
+    //!
+    //! \brief endRead Завершить чтение переднего банка
+    //! \param seq     Номер публикации, полученный в beginRead
+    //! \return        true, если прочитанные данные согласованы, иначе чтение нужно повторить
+    //!
+    bool endRead( uint32_t seq ) const
+      {
+      //Банк перезаписывается только после следующей публикации. Барьер упорядочивает
+      //чтение данных (возможно, пересекшееся с перезаписью) до повторной проверки номера
+      std::atomic_thread_fence( std::memory_order_acquire );
+      return mSeq.load( std::memory_order_relaxed ) == seq;
+      }
+
+    //!
+    //! \brief cycle Возвращает номер последней публикации
+    //! \return      Номер цикла
+    //!
+    uint32_t cycle() const { return mSeq.load( std::memory_order_acquire ); }
+  };
+
+#endif // CSSTATESTORE_H
@@ -0,0 +1,80 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     CsTagTracker - учет запросов с метками, ожидающих ответа
+
+     В режиме ответов с метками (CS_CB_TAGGED_ANSWERS) к одному устройству может
+     быть отправлено несколько запросов подряд, не дожидаясь ответов. Для каждого
+     устройства шины учитываются до CS_TAG_SEQ_COUNT запросов: команда и время
+     отправки. По байту метки в начале ответа определяется, на какой запрос он
+     получен и какова его длина, поэтому ответы могут приходить в любом порядке.
+   */
+#ifndef CSTAGTRACKER_H
+#define CSTAGTRACKER_H
+
+#include "RUPBaseClass.hpp"
+
+//!
+//! \brief The CsTagTracker class учитывает запросы с метками для всех устройств одной шины
+//!
+class CsTagTracker
+  {
+    struct Slot {
+      int64_t mTime; //!< Время отправки запроса, мкс
+      int8_t  mCmd;  //!< Команда запроса или -1, если номер свободен
+      };
+
+    Slot    mSlots[CS_DEVICE_COUNT][CS_TAG_SEQ_COUNT]; //!< Запросы по устройствам и номерам
+    uint8_t mNext[CS_DEVICE_COUNT];                    //!< Следующий выдаваемый номер для устройства
+    uint8_t mCount[CS_DEVICE_COUNT];                   //!< Количество ожидающих ответа запросов
+    int     mWindow;                                   //!< Максимальное количество ожидающих запросов к устройству
+  public:
+    //!
+    //! \brief CsTagTracker Конструктор учета запросов
+    //! \param window       Максимальное количество одновременно ожидающих ответа запросов к одному устройству
+    //!
+    CsTagTracker( int window = CS_TAG_SEQ_COUNT );
+
+    //!
+    //! \brief issue Выделить номер для нового запроса
+    //! \param id    Идентификатор устройства
+    //! \param cmd   Команда запроса
+    //! \param now   Время отправки запроса, мкс
+    //! \return      Номер запроса (0-7) или -1, если окно запросов к устройству заполнено.
+    //!              Запросу без ответа номер выдается без учета в окне
+    //!
+    int  issue( int id, int cmd, int64_t now );
+
+    //!
+    //! \brief answerLength Возвращает полную длину ответа по байту метки
+    //! \param tag          Байт метки (первый байт ответа)
+    //! \return             Длина ответа, включая метку и КС, или 0, если такой запрос не ожидается
+    //!
+    int  answerLength( char tag ) const;
+
+    //!
+    //! \brief match Сопоставить ответ с запросом и освободить номер
+    //! \param tag   Байт метки (первый байт ответа)
+    //! \param cmd   Приемник команды запроса
+    //! \param time  Приемник времени отправки запроса, мкс
+    //! \return      true, если запрос с такой меткой ожидал ответа
+    //!
+    bool match( char tag, int &cmd, int64_t &time );
+
+    //!
+    //! \brief expire  Освободить номера запросов, ответ на которые не получен за время ожидания
+    //! \param now     Текущее время, мкс
+    //! \param timeout Время ожидания, мкс
+    //! \return        Количество освобожденных номеров
+    //!
+    int  expire( int64_t now, int64_t timeout );
+
+    //!
+    //! \brief outstanding Возвращает количество ожидающих ответа запросов к устройству
+    //! \param id          Идентификатор устройства
+    //! \return            Количество запросов
+    //!
+    int  outstanding( int id ) const { return mCount[id & 0xf]; }
+  };
+
+#endif // CSTAGTRACKER_H
@@ -0,0 +1,294 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     CsTelemetryAgg - прореживание и агрегирование телеметрии
+
+     Полный поток состояния (каждый цикл управления для каждого устройства)
+     нужен только закону управления. Отображению, журналу и удаленному
+     наблюдению достаточно сводки за окно: минимума, максимума, среднего
+     и последнего значения угла, момента и значений информации.
+
+     Агрегатор получает опубликованные банки хранилища CsStateStore и ведет
+     накопители окна в виде структуры массивов того же размера, что и банк:
+     по каждому полю массивы минимума, максимума, суммы и последнего значения,
+     а также массивы количества обновлений ячейки по группам полей (угол и момент
+     обновляются ответом на "Управление", значения информации - ответом на
+     "Получить информацию"). Значение поля учитывается, только если в цикле
+     обновлена его группа. Внутренние циклы накопления не содержат ветвлений
+     (необновленные ячейки маскируются) и векторизуются компилятором.
+
+     Читающая сторона не должна накапливать банк, который может быть перезаписан
+     во время чтения: add( store, time ) копирует передний банк в агрегатор
+     и повторяет копирование, пока CsStateStore::endRead не подтвердит его
+     согласованность. Хранилище содержит только последний опубликованный банк,
+     а не очередь, поэтому агрегатор запоминает номер учтенной публикации:
+     повторный вызов до следующего publish() банк не учитывает, а публикации,
+     перезаписанные до вызова, подсчитываются в mSkipped окна. add( bank, time )
+     накапливает переданный банк без копирования и вызывается только в потоке
+     публикации (после publish()) или для уже проверенной копии.
+
+     Когда время очередного цикла (передается вызывающей стороной) выходит за
+     период окна, для накопленного окна вычисляются средние, оно передается
+     функции публикации и накопители сбрасываются; flush() публикует окно сразу.
+     Для нескольких частот публикации агрегаторы соединяются каскадом: функцией
+     публикации быстрого агрегатора назначается forward() медленного, который
+     объединяет уже свернутые окна и не обрабатывает полный поток повторно.
+   */
+#ifndef CSTELEMETRYAGG_H
+#define CSTELEMETRYAGG_H
+
+#include "CsStateStore.hpp"
+
+//Агрегируемые поля состояния
+#define CS_TELE_ANGLE   0 //Текущий угол
+#define CS_TELE_MOMENT  1 //Текущий момент
+#define CS_TELE_INFO0   2 //Значение информации 0
+#define CS_TELE_INFO1   3 //Значение информации 1
+#define CS_TELE_INFO2   4 //Значение информации 2
+#define CS_TELE_FIELDS  5 //Количество полей
+
+//Группы полей с общим признаком обновления
+#define CS_TELE_GROUP_CONTROL 0 //Угол и момент (ответ на "Управление")
+#define CS_TELE_GROUP_INFO    1 //Значения информации (ответ на "Получить информацию")
+#define CS_TELE_GROUPS        2 //Количество групп
+
+//!
+//! \brief csTeleGroup Возвращает группу поля
+//! \param field       Поле CS_TELE_...
+//! \return            Группа CS_TELE_GROUP_...
+//!
+constexpr int csTeleGroup( int field ) { return field <= CS_TELE_MOMENT ? CS_TELE_GROUP_CONTROL : CS_TELE_GROUP_INFO; }
+
+//Максимальное количество циклов в окне, при котором сумма 16-битных значений не переполняется
+#define CS_TELE_MAX_CYCLES 65535
+
+//!
+//! \brief The CsTelemetryWindow struct сводка состояния устройств за окно в виде структуры массивов
+//!
+template <int slots>
+struct CsTelemetryWindow {
+    alignas(CS_STATE_ALIGN) int16_t  mMin[CS_TELE_FIELDS][slots];  //!< Минимальное значение
+    alignas(CS_STATE_ALIGN) int16_t  mMax[CS_TELE_FIELDS][slots];  //!< Максимальное значение
+    alignas(CS_STATE_ALIGN) int16_t  mMean[CS_TELE_FIELDS][slots]; //!< Среднее значение (вычисляется при публикации)
+    alignas(CS_STATE_ALIGN) int16_t  mLast[CS_TELE_FIELDS][slots]; //!< Последнее полученное значение
+    alignas(CS_STATE_ALIGN) int32_t  mSum[CS_TELE_FIELDS][slots];  //!< Сумма значений
+    alignas(CS_STATE_ALIGN) uint32_t mCount[CS_TELE_GROUPS][slots]; //!< Количество обновлений группы полей ячейки за окно
+    int64_t                          mStart;                       //!< Время первого цикла окна, мкс
+    int64_t                          mEnd;                         //!< Время последнего цикла окна, мкс
+    uint32_t                         mCycles;                      //!< Количество циклов в окне
+    uint32_t                         mSkipped;                     //!< Количество опубликованных банков, не попавших в окно
+
+    //!
+    //! \brief reset Сбросить накопители окна. Последние значения сохраняются
+    //!
+    void reset()
+      {
+      for( int f = 0; f < CS_TELE_FIELDS; f++ )
+        for( int i = 0; i < slots; i++ ) {
+          mMin[f][i] = INT16_MAX;
+          mMax[f][i] = INT16_MIN;
+          mSum[f][i] = 0;
+          }
+      for( int g = 0; g < CS_TELE_GROUPS; g++ )
+        for( int i = 0; i < slots; i++ )
+          mCount[g][i] = 0;
+      mStart  = 0;
+      mEnd    = 0;
+      mCycles  = 0;
+      mSkipped = 0;
+      }
+  };
+
+
+
+
+//!
+//! \brief The CsTelemetryAgg class агрегирует состояние устройств buses шин за окна заданной длительности
+//!
+template <int buses>
+class CsTelemetryAgg
+  {
+  public:
+    static constexpr int slots = CsStateStore<buses>::slots;
+
+    using Bank   = typename CsStateStore<buses>::Bank;
+    using Window = CsTelemetryWindow<slots>;
+
+    //!
+    //! \brief Fn      Функция публикации окна
+    //! \param context Контекст, переданный при создании агрегатора
+    //! \param window  Сводка за окно, действительна только во время вызова
+    //!
+    typedef void (*Fn)( void *context, const Window &window );
+
+  private:
+    Window   mWindow;  //!< Накапливаемое окно
+    Bank     mCopy;    //!< Согласованная копия переднего банка хранилища
+    uint32_t mSeq;     //!< Номер последней учтенной публикации хранилища
+    int64_t  mPeriod;  //!< Длительность окна, мкс
+    Fn       mHandler; //!< Функция публикации
+    void    *mContext; //!< Контекст функции публикации
+  public:
+    //!
+    //! \brief CsTelemetryAgg Конструктор агрегатора
+    //! \param period         Длительность окна, мкс (0 - публикация каждого цикла)
+    //! \param handler        Функция публикации окна
+    //! \param context        Контекст функции публикации
+    //!
+    CsTelemetryAgg( int64_t period, Fn handler, void *context ) : mSeq(0), mPeriod(period), mHandler(handler), mContext(context)
+      {
+      memset( mWindow.mLast, 0, sizeof(mWindow.mLast) );
+      memset( mWindow.mMean, 0, sizeof(mWindow.mMean) );
+      mWindow.reset();
+      }
+
+    //!
+    //! \brief setPeriod Установить длительность окна. Действует с текущего окна
+    //! \param period    Длительность окна, мкс
+    //!
+    void setPeriod( int64_t period ) { mPeriod = period; }
+
+    //!
+    //! \brief add   Учесть очередной опубликованный банк состояния. Банк копируется, копия
+    //! учитывается только после подтверждения согласованности (CsStateStore::endRead).
+    //! Уже учтенный банк повторно не учитывается, пропущенные публикации добавляются в mSkipped
+    //! \param store Хранилище состояния
+    //! \param time  Время цикла, мкс
+    //! \return      true, если учтен новый банк, false, если с предыдущего вызова публикаций не было
+    //!
+    bool add( const CsStateStore<buses> &store, int64_t time )
+      {
+      uint32_t seq;
+      do {
+        if( store.cycle() == mSeq ) return false;
+        memcpy( &mCopy, &store.beginRead( seq ), sizeof(Bank) );
+        }
+      while( !store.endRead( seq ) );
+      uint32_t skipped = seq - mSeq - 1;
+      mSeq = seq;
+      add( mCopy, time );
+      mWindow.mSkipped += skipped;
+      return true;
+      }
+
+    //!
+    //! \brief add  Учесть банк состояния, который не изменяется во время вызова: передний банк
+    //! в потоке публикации или согласованную копию
+    //! \param bank Банк состояния
+    //! \param time Время цикла, мкс
+    //!
+    void add( const Bank &bank, int64_t time )
+      {
+      //Окно охватывает циклы с временем от mStart до mStart + mPeriod, не включая конец
+      if( mWindow.mCycles && (time - mWindow.mStart >= mPeriod || mWindow.mCycles >= CS_TELE_MAX_CYCLES) )
+        flush();
+      if( mWindow.mCycles == 0 ) mWindow.mStart = time;
+      const int16_t *src[CS_TELE_FIELDS]   = { bank.mAngle, bank.mMoment, bank.mInfo0, bank.mInfo1, bank.mInfo2 };
+      const uint8_t *flags[CS_TELE_GROUPS] = { bank.mValidControl, bank.mValidInfo };
+      for( int f = 0; f < CS_TELE_FIELDS; f++ ) {
+        const uint8_t *__restrict valid = flags[csTeleGroup(f)];
+        const int16_t *__restrict val  = src[f];
+        int16_t       *__restrict vmin = mWindow.mMin[f];
+        int16_t       *__restrict vmax = mWindow.mMax[f];
+        int16_t       *__restrict last = mWindow.mLast[f];
+        int32_t       *__restrict sum  = mWindow.mSum[f];
+        for( int i = 0; i < slots; i++ ) {
+          //Необновленная ячейка маскируется нейтральным значением, что исключает ветвления
+          int16_t mask = valid[i] ? -1 : 0;
+          int16_t v    = val[i] & mask;
+          int16_t lo   = v | (INT16_MAX & ~mask);
+          int16_t hi   = v | (INT16_MIN & ~mask);
+          vmin[i] = lo < vmin[i] ? lo : vmin[i];
+          vmax[i] = hi > vmax[i] ? hi : vmax[i];
+          last[i] = v | (last[i] & ~mask);
+          sum[i] += v;
+          }
+        }
+      for( int g = 0; g < CS_TELE_GROUPS; g++ ) {
+        const uint8_t  *__restrict valid = flags[g];
+        uint32_t       *__restrict count = mWindow.mCount[g];
+        for( int i = 0; i < slots; i++ )
+          count[i] += valid[i] != 0;
+        }
+      mWindow.mCycles++;
+      mWindow.mEnd = time;
+      }
+
+    //!
+    //! \brief merge  Объединить с накапливаемым окном сводку более короткого окна
+    //! \param window Сводка более короткого окна
+    //!
+    void merge( const Window &window )
+      {
+      if( mWindow.mCycles && (window.mStart - mWindow.mStart >= mPeriod || mWindow.mCycles + window.mCycles > CS_TELE_MAX_CYCLES) )
+        flush();
+      if( mWindow.mCycles == 0 ) mWindow.mStart = window.mStart;
+      for( int f = 0; f < CS_TELE_FIELDS; f++ ) {
+        const int16_t  *__restrict wmin  = window.mMin[f];
+        const int16_t  *__restrict wmax  = window.mMax[f];
+        const int16_t  *__restrict wlast = window.mLast[f];
+        const int32_t  *__restrict wsum  = window.mSum[f];
+        const uint32_t *__restrict count = window.mCount[csTeleGroup(f)];
+        int16_t        *__restrict vmin  = mWindow.mMin[f];
+        int16_t        *__restrict vmax  = mWindow.mMax[f];
+        int16_t        *__restrict last  = mWindow.mLast[f];
+        int32_t        *__restrict sum   = mWindow.mSum[f];
+        for( int i = 0; i < slots; i++ ) {
+          int16_t mask = count[i] ? -1 : 0;
+          vmin[i] = wmin[i] < vmin[i] ? wmin[i] : vmin[i];
+          vmax[i] = wmax[i] > vmax[i] ? wmax[i] : vmax[i];
+          last[i] = (wlast[i] & mask) | (last[i] & ~mask);
+          sum[i] += wsum[i];
+          }
+        }
+      for( int g = 0; g < CS_TELE_GROUPS; g++ )
+        for( int i = 0; i < slots; i++ )
+          mWindow.mCount[g][i] += window.mCount[g][i];
+      mWindow.mCycles  += window.mCycles;
+      mWindow.mSkipped += window.mSkipped;
+      mWindow.mEnd      = window.mEnd;
+      }
+
+    //!
+    //! \brief forward Функция публикации для каскадного соединения: объединяет окно
+    //! быстрого агрегатора с окном данного агрегатора
+    //! \param context Агрегатор более длинного окна
+    //! \param window  Сводка более короткого окна
+    //!
+    static void forward( void *context, const Window &window ) { static_cast<CsTelemetryAgg*>(context)->merge( window ); }
+
+    //!
+    //! \brief flush Опубликовать накопленное окно досрочно. Пустое окно не публикуется
+    //!
+    void flush()
+      {
+      if( mWindow.mCycles == 0 ) return;
+      for( int f = 0; f < CS_TELE_FIELDS; f++ ) {
+        const int32_t  *sum   = mWindow.mSum[f];
+        const int16_t  *last  = mWindow.mLast[f];
+        const uint32_t *count = mWindow.mCount[csTeleGroup(f)];
+        int16_t        *mean  = mWindow.mMean[f];
+        for( int i = 0; i < slots; i++ )
+          //Для ячеек без обновлений в окне средним считается последнее известное значение
+          mean[i] = count[i] ? static_cast<int16_t>( sum[i] / static_cast<int32_t>(count[i]) ) : last[i];
+        }
+      if( mHandler ) mHandler( mContext, mWindow );
+      mWindow.reset();
+      }
+
+    //!
+    //! \brief window Возвращает накапливаемое окно
+    //! \return       Окно (средние не вычислены)
+    //!
+    const Window &window() const { return mWindow; }
+
+    //!
+    //! \brief slot Возвращает индекс ячейки устройства
+    //! \param bus  Номер шины
+    //! \param id   Идентификатор устройства
+    //! \return     Индекс ячейки в массивах окна
+    //!
+    static int slot( int bus, int id ) { return CsStateStore<buses>::slot( bus, id ); }
+  };
+
+#endif // CSTELEMETRYAGG_H
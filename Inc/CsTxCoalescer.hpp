@@ -0,0 +1,118 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     CsTxCoalescer - объединение закодированных сообщений в пакеты для передачи
+
+     При работе через мосты USB-serial каждая отдельная запись в порт превращается
+     в отдельную передачу USB. Таким образом 15 отдельных команд управления стоят
+     15 кадров USB задержки. Для устранения этого сообщения накапливаются в буфере
+     и записываются в порт блоками, равными размеру пакета моста (64 или 512 байт).
+
+     Чтобы накопление не вносило неограниченную задержку, данные не удерживаются
+     в буфере дольше заданного бюджета задержки (проверяется в poll). В конце каждого
+     цикла управления вызывается flushCycle, гарантирующий, что воздействия не
+     переходят через границу цикла.
+
+     Время передается вызывающей стороной в микросекундах, поэтому класс не зависит
+     от платформы.
+   */
+#ifndef CSTXCOALESCER_H
+#define CSTXCOALESCER_H
+
+#include <stdint.h>
+
+//Максимальный размер пакета моста USB-serial (high speed)
+#define CS_TX_PACKET_MAX     512
+
+//!
+//! \brief CsTxWriteFn Функция записи блока данных в порт
+//! \param context     Контекст, переданный при создании объединителя
+//! \param data        Записываемые данные
+//! \param size        Размер данных в байтах
+//!
+typedef void (*CsTxWriteFn)( void *context, const char *data, int size );
+
+
+//!
+//! \brief The CsTxCoalescer class накапливает закодированные сообщения и записывает
+//! их в порт блоками размера пакета моста в пределах бюджета задержки.
+//!
+class CsTxCoalescer
+  {
+    char        mBuffer[CS_TX_PACKET_MAX]; //!< Буфер накапливаемых данных
+    int         mLength;                   //!< Количество данных в буфере
+    int         mPacketSize;               //!< Размер пакета моста
+    uint32_t    mBudget;                   //!< Бюджет задержки, мкс
+    uint32_t    mFirstTime;                //!< Время поступления первого байта в буфер, мкс
+    CsTxWriteFn mWrite;                    //!< Функция записи в порт
+    void       *mContext;                  //!< Контекст функции записи
+    uint32_t    mWrites;                   //!< Количество выполненных записей в порт
+    uint32_t    mBytes;                    //!< Количество записанных байтов
+  public:
+    //!
+    //! \brief CsTxCoalescer Конструктор объединителя
+    //! \param write         Функция записи в порт
+    //! \param context       Контекст функции записи
+    //! \param packetSize    Размер пакета моста (64 или 512 байт)
+    //! \param budget        Бюджет задержки, мкс
+    //!
+    CsTxCoalescer( CsTxWriteFn write, void *context, int packetSize = 64, uint32_t budget = 250 );
+
+    //!
+    //! \brief append Добавить закодированное сообщение. Полностью заполненные пакеты сразу записываются в порт
+    //! \param frame  Закодированное сообщение
+    //! \param size   Длина сообщения
+    //! \param now    Текущее время, мкс
+    //!
+    void append( const char *frame, int size, uint32_t now );
+
+    //!
+    //! \brief append Добавить сформированное сообщение CsMessageOut
+    //! \param msg    Сформированное сообщение
+    //! \param now    Текущее время, мкс
+    //!
+    template <class CsMessageOutTmpl>
+    void append( const CsMessageOutTmpl &msg, uint32_t now ) { append( msg.buffer(), msg.length(), now ); }
+
+    //!
+    //! \brief poll Записать накопленные данные, если истек бюджет задержки
+    //! \param now  Текущее время, мкс
+    //!
+    void poll( uint32_t now );
+
+    //!
+    //! \brief flushCycle Записать все накопленные данные. Вызывается на границе цикла управления
+    //!
+    void flushCycle() { flush(); }
+
+    //!
+    //! \brief flush Записать все накопленные данные
+    //!
+    void flush();
+
+    //!
+    //! \brief pending Возвращает количество данных, ожидающих записи
+    //! \return        Количество байтов в буфере
+    //!
+    int  pending() const { return mLength; }
+
+    //!
+    //! \brief packetSize Возвращает размер пакета моста
+    //! \return           Размер пакета моста
+    //!
+    int  packetSize() const { return mPacketSize; }
+
+    //!
+    //! \brief writes Возвращает количество выполненных записей в порт
+    //! \return       Количество записей
+    //!
+    uint32_t writes() const { return mWrites; }
+
+    //!
+    //! \brief bytes Возвращает количество записанных байтов
+    //! \return      Количество байтов
+    //!
+    uint32_t bytes() const { return mBytes; }
+  };
+
+#endif // CSTXCOALESCER_H
@@ -0,0 +1,138 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     CsWorkload - генератор синтетического потока обмена для проверки быстродействия
+
+     Для проверки быстродействия выделителя запросов, декодеров и индекса записей
+     нужны реалистичные потоки байтов: смесь команд разной длины (CS_CMD_LENGHTS),
+     ответы, эхо запросов (полудуплексный адаптер принимает собственную передачу),
+     шум и искаженные байты. Генератор строит такой поток из последовательности
+     обменов "запрос - эхо - ответ - шум" с заданными вероятностями.
+
+     Поток полностью определяется начальным значением генератора случайных чисел
+     и параметрами CsWorkloadMix и не зависит от того, какими блоками он выбирается,
+     поэтому все проверки могут использовать одни и те же воспроизводимые данные
+     любого объема, в том числе в кольцевом буфере с произвольным положением
+     перехода через границу.
+   */
+#ifndef CSWORKLOAD_H
+#define CSWORKLOAD_H
+
+#include "RUPBaseClass.hpp"
+
+//!
+//! \brief The CsWorkloadMix struct параметры синтетического потока обмена
+//!
+struct CsWorkloadMix {
+    uint32_t mWeights[8];    //!< Относительная частота команд по кодам cmd, зарезервированные команды игнорируются
+    uint16_t mIds;           //!< Маска идентификаторов устройств (бит id), бит CS_ID_BROADCAST - широковещательная запись
+    uint8_t  mAnswerPercent; //!< Вероятность ответа на запрос, %
+    uint8_t  mEchoPercent;   //!< Вероятность эха запроса, %
+    uint8_t  mNoisePercent;  //!< Вероятность шума (1-8 случайных байтов) после обмена, %
+    uint32_t mErrorPpm;      //!< Средняя частота искаженных байтов, на миллион
+    bool     mTagged;        //!< Запросы и ответы с метками
+
+    //Смесь по умолчанию: в основном команды управления с ответами, без ошибок
+    CsWorkloadMix() :
+      mWeights{ 70, 10, 0, 0, 0, 5, 15, 0 },
+      mIds(0x7ffe),
+      mAnswerPercent(100),
+      mEchoPercent(0),
+      mNoisePercent(0),
+      mErrorPpm(0),
+      mTagged(false) {}
+  };
+
+
+
+//!
+//! \brief The CsWorkload class генератор воспроизводимого синтетического потока обмена
+//!
+class CsWorkload
+  {
+    uint64_t      mState;      //!< Состояние генератора случайных чисел
+    CsWorkloadMix mMix;        //!< Параметры потока
+    uint32_t      mWeightSum;  //!< Сумма частот команд
+    uint8_t       mSeq[CS_DEVICE_COUNT]; //!< Номера запросов по устройствам для режима с метками
+    char          mUnit[64];   //!< Текущий обмен
+    int           mUnitLength; //!< Длина текущего обмена
+    int           mUnitPtr;    //!< Количество выбранных байтов текущего обмена
+    uint32_t      mNextError;  //!< Количество байтов до следующего искаженного байта
+    uint64_t      mQueries;    //!< Количество сформированных запросов
+    uint64_t      mAnswers;    //!< Количество сформированных ответов
+    uint64_t      mErrors;     //!< Количество искаженных байтов
+  public:
+    //!
+    //! \brief CsWorkload Конструктор генератора
+    //! \param seed       Начальное значение генератора случайных чисел
+    //! \param mix        Параметры потока
+    //!
+    CsWorkload( uint64_t seed, const CsWorkloadMix &mix = CsWorkloadMix() );
+
+    //!
+    //! \brief fill Заполнить линейный буфер очередными байтами потока
+    //! \param dst  Буфер-приемник
+    //! \param size Количество байтов
+    //!
+    void     fill( char *dst, int64_t size );
+
+    //!
+    //! \brief fillRing Записать очередные байты потока в циклический буфер
+    //! \param ring     Циклический буфер
+    //! \param ringSize Размер циклического буфера
+    //! \param tail     Индекс, по которому записывается первый байт
+    //! \param count    Количество байтов
+    //! \return         Индекс, по которому будет записан следующий байт
+    //!
+    int      fillRing( char *ring, int ringSize, int tail, int count );
+
+    //!
+    //! \brief writeFile Записать очередные байты потока в файл записи обмена
+    //! \param path      Путь к файлу
+    //! \param size      Количество байтов
+    //! \return          true при успешной записи
+    //!
+    bool     writeFile( const char *path, int64_t size );
+
+    //!
+    //! \brief random Возвращает очередное случайное число (xorshift64*)
+    //! \return       Случайное число
+    //!
+    uint64_t random()
+      {
+      mState ^= mState >> 12;
+      mState ^= mState << 25;
+      mState ^= mState >> 27;
+      return mState * 0x2545f4914f6cdd1dull;
+      }
+
+    //!
+    //! \brief random Возвращает случайное число в диапазоне [0, range)
+    //! \param range  Размер диапазона
+    //! \return       Случайное число
+    //!
+    uint32_t random( uint32_t range ) { return static_cast<uint32_t>( ((random() >> 32) * range) >> 32 ); }
+
+    //!
+    //! \brief queries Возвращает количество сформированных запросов (включая еще не выбранные байты)
+    //! \return        Количество запросов
+    //!
+    uint64_t queries() const { return mQueries; }
+
+    //!
+    //! \brief answers Возвращает количество сформированных ответов
+    //! \return        Количество ответов
+    //!
+    uint64_t answers() const { return mAnswers; }
+
+    //!
+    //! \brief errors Возвращает количество искаженных байтов
+    //! \return       Количество искаженных байтов
+    //!
+    uint64_t errors() const { return mErrors; }
+
+  private:
+    void     nextUnit();
+  };
+
+#endif // CSWORKLOAD_H
@@ -0,0 +1,87 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     CsWriteAll - широковещательная запись параметра с проверочным чтением
+
+     Запись одного и того же параметра (например, режима CS_CB_DEVICE_MODE или общих
+     коэффициентов регуляторов) в 15 двигателей требует 15 обменов makeQueryWrite.
+     Широковещательная запись (makeQueryWriteAll, идентификатор CS_ID_BROADCAST)
+     выполняется одним сообщением без ответа. При необходимости затем выполняется
+     проверочное чтение параметра из заданных устройств; устройства, вернувшие иное
+     значение или не ответившие, отмечаются и могут быть записаны индивидуально.
+   */
+#ifndef CSWRITEALL_H
+#define CSWRITEALL_H
+
+#include "RUPBaseClass.hpp"
+
+//!
+//! \brief The CsWriteAll class формирует широковещательную запись параметра и последовательность
+//! проверочных чтений для заданного набора устройств
+//!
+class CsWriteAll
+  {
+    int      mIndex;   //!< Индекс параметра
+    int      mValue;   //!< Записываемое значение
+    uint16_t mPending; //!< Маска устройств, ожидающих проверочного чтения
+    uint16_t mFailed;  //!< Маска устройств, не подтвердивших запись
+    int      mCurrent; //!< Устройство, которому отправлен текущий проверочный запрос, или -1
+  public:
+    //!
+    //! \brief CsWriteAll Конструктор широковещательной записи
+    //! \param index      Индекс параметра
+    //! \param value      Записываемое значение
+    //! \param verify     Маска идентификаторов устройств для проверочного чтения (бит id), 0 - без проверки
+    //!
+    CsWriteAll( int index, int value, uint16_t verify = 0 ) :
+      mIndex(index), mValue(value), mPending(verify & 0x7fff), mFailed(0), mCurrent(-1) {}
+
+    //!
+    //! \brief makeQueryWrite Сформировать широковещательную запись параметра
+    //! \param msg            Кодировщик сообщения
+    //!
+    template <class CsMessageOutTmpl>
+    void makeQueryWrite( CsMessageOutTmpl &msg ) const { msg.makeQueryWriteAll( mIndex, mValue ); }
+
+    //!
+    //! \brief makeQueryVerify Сформировать очередной проверочный запрос чтения
+    //! \param msg             Кодировщик сообщения
+    //! \return                Идентификатор опрашиваемого устройства или -1, если проверка завершена
+    //!
+    template <class CsMessageOutTmpl>
+    int  makeQueryVerify( CsMessageOutTmpl &msg )
+      {
+      mCurrent = next();
+      if( mCurrent >= 0 )
+        msg.makeQueryRead( mCurrent, mIndex );
+      return mCurrent;
+      }
+
+    //!
+    //! \brief answer Обработать ответ на проверочный запрос
+    //! \param value  Прочитанное значение параметра
+    //!
+    void answer( int value );
+
+    //!
+    //! \brief timeout Сообщить об отсутствии ответа на проверочный запрос
+    //!
+    void timeout();
+
+    //!
+    //! \brief done Проверить завершение проверки
+    //! \return     true, если все проверочные чтения выполнены
+    //!
+    bool done() const { return mPending == 0; }
+
+    //!
+    //! \brief failed Возвращает маску устройств, не подтвердивших запись
+    //! \return       Маска идентификаторов (бит id)
+    //!
+    uint16_t failed() const { return mFailed; }
+
+  private:
+    int  next() const;
+  };
+
+#endif // CSWRITEALL_H
@@ -35,7 +35,7 @@
        Команды cmd:
        0 - команда управления, отправка данных воздействия 16бит и получение данных состояния 2*16бит
        1 - получить данные состояния 3*16бит
-       2 - резерв
+       2 - команда управления без ответа, отправка данных воздействия 16бит
        3
        4
        5 - записать параметр, индекс параметра 16бит, значение параметра 32бит
@@ -55,11 +55,19 @@
        ответ
          3*16 значений состояния, КС
 
+       [2] Команда управления без ответа:
+         Заголовок, Воздействие 2 байт, КС
+       ответа нет, шина сразу свободна для следующего запроса
+
        [5] Записать параметр:
          Заголовок, Индекс параметра (2байт), Параметр (4байта), КС
        ответ
          Параметр (4байта), КС
 
+       [5] Записать параметр во все устройства (id = 15):
+         Заголовок, Индекс параметра (2байт), Параметр (4байта), КС
+       ответа нет, параметр записывают все устройства на шине
+
        [6] Прочитать параметр:
          Заголовок, Индекс параметра (2байт), КС
        ответ
@@ -80,6 +88,24 @@
 
 
 
+   Режим ответов с метками (включается параметром CS_CB_TAGGED_ANSWERS)
+     Обычный ответ не имеет заголовка, поэтому к устройству может быть отправлен только один
+     запрос, а сопоставление ответов держится на строгом порядке. В режиме с метками сразу
+     после заголовка запроса передается байт метки, и ответ начинается с такого же байта:
+       Метка
+       7 6 5 4  3 2 1 0
+       1 -seq-  --id---
+     seq - номер запроса (0-7), id - идентификатор устройства. Длины запроса и ответа
+     увеличиваются на 1 байт. Это позволяет держать несколько запросов к устройству
+     одновременно и сопоставлять ответы вне очереди.
+
+     Режим включается для каждого устройства отдельно, поэтому на одной шине могут
+     находиться устройства с метками и без них. Разборщики получают маску устройств
+     в режиме с метками (бит id, CS_TAGGED_ALL - все устройства) и определяют наличие
+     метки по идентификатору в заголовке.
+
+
+
    Учитывая, что один из вариантов обмена с хостом - это uart, то целесообразно
    унифицировать обмен между хостом и контроллером.
    Поскольку контроллер один и различие по идентификатору не требуется, решено
@@ -93,6 +119,9 @@
 
  История
    12.01.2023  v1 начал вести версии
+   18.10.2026  v2 таблица возможностей устройства (CS_CB_CAPABILITIES): ответы с метками,
+               широковещательная запись, кадрирование COBS, повышенная скорость обмена
+   18.10.2026  v2 команда управления без ответа CS_CMD_MSG_CONTROL_NA (возможность CS_CAP_CONTROL_NA)
    */
 #ifndef CSMESSAGE_H
 #define CSMESSAGE_H
@@ -100,21 +129,57 @@
 #include <stdint.h>
 
 //Версия сообщения
-#define CS_MESSAGE_VERSION     1
+#define CS_MESSAGE_VERSION     2
+
+//Признак таблицы возможностей: старшие 16 бит значения CS_CB_CAPABILITIES.
+//Устройства до версии 2 не знают этого параметра и не могут вернуть признак
+#define CS_CAP_SIGNATURE       0x5a43
 
 //Команды
 #define CS_CMD_MSG_CONTROL     0    //!< Управление 16бит, возвращает состояние 2*16бит
 #define CS_CMD_MSG_INFO        1    //!< Получить информацию, возвращает набор параметров 3*16бит
+#define CS_CMD_MSG_CONTROL_NA  2    //!< Управление 16бит без ответа
 #define CS_CMD_MSG_WRITE       5    //!< Запись параметра (индекс 16бит, значение 32бит, возвращает записанное значение 32бит)
 #define CS_CMD_MSG_READ        6    //!< Чтение параметра (индекс 16бит, возвращает значение 32бит)
 #define CS_CMD_MSG_FLASH       7    //!< Прошивка (адрес 32бит, значение 32бит)
 
+//Универсальный идентификатор: прошивка и широковещательная запись параметра
+#define CS_ID_BROADCAST       15
+
+//Количество идентификаторов устройств на одной шине
+#define CS_DEVICE_COUNT       16
+
+//Количество номеров запросов в режиме ответов с метками
+#define CS_TAG_SEQ_COUNT       8
+
+//Маска режима ответов с метками: все устройства шины
+#define CS_TAGGED_ALL     0xffff
+
 //Длина сообщения прошивки
 #define CS_CMD_FLASH_LENGTH   12
 
-//                             CTRL INFO RSV        WR RD FLASH
-//                              0    1    2  3  4    5  6  7
-#define CS_CMD_LENGHTS        { 5,   2,   0, 0, 0,   9, 5, CS_CMD_FLASH_LENGTH } //!< Длины команд
+//                             CTRL INFO CTNA RSV   WR RD FLASH
+//                              0    1    2    3  4  5  6  7
+#define CS_CMD_LENGHTS        { 5,   2,   5,   0, 0, 9, 5, CS_CMD_FLASH_LENGTH } //!< Длины команд
+
+//Смещения полей в битах от начала данных сообщения (после заголовка и метки)
+#define CS_BIT_CONTROL_VALUE   0 //!< Запрос "Управление" и "Управление без ответа": воздействие 16бит
+#define CS_BIT_WRITE_INDEX     0 //!< Запрос "Запись параметра": индекс 16бит
+#define CS_BIT_WRITE_VALUE    16 //!< Запрос "Запись параметра": значение 32бит
+#define CS_BIT_READ_INDEX      0 //!< Запрос "Чтение параметра": индекс 16бит
+#define CS_BIT_FLASH_ADDRESS   0 //!< Запрос "Прошивка": адрес или команда 32бит
+#define CS_BIT_FLASH_VALUE    32 //!< Запрос "Прошивка": значение 32бит
+#define CS_BIT_ANSWER_ANGLE    0 //!< Ответ на "Управление": угол 16бит
+#define CS_BIT_ANSWER_MOMENT  16 //!< Ответ на "Управление": момент 16бит
+#define CS_BIT_ANSWER_INFO0    0 //!< Ответ на "Получить информацию": значение 0 16бит
+#define CS_BIT_ANSWER_INFO1   16 //!< Ответ на "Получить информацию": значение 1 16бит
+#define CS_BIT_ANSWER_INFO2   32 //!< Ответ на "Получить информацию": значение 2 16бит
+#define CS_BIT_ANSWER_VALUE    0 //!< Ответ на "Запись/Чтение параметра": значение 32бит
+
+//Длины ответов на команды, включая КС
+//                             CTRL INFO CTNA RSV   WR RD FLASH
+//                              0    1    2    3  4  5  6  7
+#define CS_ANSWER_LENGHTS     { 6,   8,   0,   0, 0, 6, 6, 7 } //!< Длины ответов
 
 
 //Сигнатуры устройств
@@ -142,6 +207,20 @@
 
 #define CS_CB_UART_ZUBR_BASE   5
 #define CS_CB_BAUDRATE         5 //!< Скорость обмена
+#define CS_CB_HOST_FRAMING     6 //!< Кадрирование обмена с хостом (CS_HOST_FRAMING_...)
+#define CS_CB_TAGGED_ANSWERS   7 //!< Режим ответов с метками (0 - выключен, 1 - включен)
+#define CS_CB_CAPABILITIES     8 //!< Таблица возможностей устройства: CS_CAP_SIGNATURE << 16 | CS_CAP_..., начиная с версии 2
+
+//Возможности устройства
+#define CS_CAP_TAGGED_ANSWERS  0x0001 //!< Ответы с метками
+#define CS_CAP_WRITE_ALL       0x0002 //!< Широковещательная запись параметра
+#define CS_CAP_HOST_COBS       0x0004 //!< Кадрирование COBS на линии с хостом
+#define CS_CAP_HIGH_BAUD       0x0008 //!< Повышенная скорость обмена (CS_CB_BAUDRATE)
+#define CS_CAP_CONTROL_NA      0x0010 //!< Команда управления без ответа (CS_CMD_MSG_CONTROL_NA)
+
+//Способы кадрирования обмена с хостом
+#define CS_HOST_FRAMING_7BIT   0 //!< Упаковка по 7 бит, старший бит - признак команда-данные, завершение \n
+#define CS_HOST_FRAMING_COBS   1 //!< Полные 8-битные данные, кадрирование COBS, завершение 0
 
 
 //Загрузчик Flash серводвигателей в металлическом и пластиковом корпусах
@@ -223,18 +302,105 @@
 #define CS_PWM_CENTRAL             20000 //!< Нулевое значение ШИМ
 
 
+//Таблицы длин, доступные на этапе компиляции
+constexpr signed char csCmdLengths[8]    = CS_CMD_LENGHTS;    //!< Длины команд
+constexpr signed char csAnswerLengths[8] = CS_ANSWER_LENGHTS; //!< Длины ответов
+
 inline int csMessageId( char ch ) { return ch & 0xf; }
 
 inline int csMessageCmd( char ch ) { return (ch >> 4) & 0x7; }
 
+inline char csMessageTag( int id, int seq ) { return 0x80 | ((seq << 4) & 0x70) | (id & 0xf); }
+
+inline int csTagSeq( char ch ) { return (ch >> 4) & 0x7; }
 
-class CsMessageOut
+//!
+//! \brief csTagLength Возвращает количество байтов метки в сообщениях устройства
+//! \param tagged      Маска устройств шины, работающих в режиме ответов с метками (бит id)
+//! \param id          Идентификатор устройства
+//! \return            1, если устройство работает с метками, иначе 0
+//!
+inline int csTagLength( uint16_t tagged, int id ) { return (tagged >> (id & 0xf)) & 1; }
+
+//!
+//! \brief csMessageLength Возвращает полную длину запроса (включая КС) по байту заголовка
+//! \param ch              Байт заголовка
+//! \return                Длина запроса или 0 для зарезервированных команд
+//!
+inline int csMessageLength( char ch ) { return csCmdLengths[csMessageCmd(ch)]; }
+
+//Количество битов в линии на один байт UART: старт, 8 бит данных, стоп
+#define CS_UART_BITS_PER_BYTE     10
+
+//!
+//! \brief csWireTime Время передачи блока байтов по линии
+//! \param bytes      Количество байтов
+//! \param baud       Скорость обмена, бод
+//! \return           Время передачи, мкс
+//!
+inline int csWireTime( int bytes, int baud ) { return static_cast<int>( static_cast<int64_t>(bytes) * CS_UART_BITS_PER_BYTE * 1000000 / baud ); }
+
+//!
+//! \brief csExchangeTime Время передачи по линии запроса и ответа на него (без учета времени реакции устройства)
+//! \param cmd            Команда
+//! \param baud           Скорость обмена, бод
+//! \return               Время передачи, мкс
+//!
+inline int csExchangeTime( int cmd, int baud ) { return csWireTime( csCmdLengths[cmd & 0x7] + csAnswerLengths[cmd & 0x7], baud ); }
+
+
+//!
+//! \brief floatToUInt Упаковка числа с плавающей точкой в тридцатидвухразрядную ячейку
+//! \param val         Число с плавающей точкой
+//! \return            Упакованное число с плавающей точкой
+//!
+inline uint32_t floatToUInt( float val )
   {
-    char  mBuffer[64]; //! Буфер для размещения закодированных данных
-    int   mPtr;        //! Номер текущего байта
-    int   mUsedBits;   //! Количество свободных битов в текущем байте
+  // We need to do this in order to access the bits from our float
+  uint32_t *u = reinterpret_cast<uint32_t*>(&val);
+  return *u;
+  }
+
+//!
+//! \brief floatFromUInt Распаковка из тридцатидвухразрядной ячейки в число с плавающей точкой
+//! \param val           Упакованное число с плавающей точкой
+//! \return              Число с плавающей точкой
+//!
+inline float    floatFromUInt( uint32_t val )
+  {
+  float *f = reinterpret_cast<float*>(&val);
+  return *f;
+  }
+
+
+
+
+//!
+//! \brief csMessageCrc Вычисление контрольной суммы для блока данных
+//! \param buf  Буфер с данными, на которых вычисляется контрольная сумма
+//! \param size Размер данных в байтах
+//! \return     Контрольная сумма
+//!
+int csMessageCrc( const char *buf0, int size0, const char *buf1 = nullptr, int size1 = 0 );
+
+
+
+
+//!
+//! \brief The CsMessageOutT class кодирует сообщение в буфер заданного размера.
+//! Размер буфера capacity должен превышать полную длину сообщения на 1 байт (завершающий 0),
+//! а при использовании hostEnd - на 2 байта. Для стандартных команд размер вычисляется
+//! на этапе компиляции (CsQueryOut, CsAnswerOut), что позволяет хранить большое
+//! количество подготовленных сообщений компактно.
+//!
+template <int capacity>
+class CsMessageOutT
+  {
+    char    mBuffer[capacity]; //! Буфер для размещения закодированных данных
+    int16_t mPtr;              //! Номер текущего байта
+    int8_t  mUsedBits;         //! Количество свободных битов в текущем байте
   public:
-    CsMessageOut() : mPtr(0), mUsedBits(0) {}
+    CsMessageOutT() : mPtr(0), mUsedBits(0) {}
 
     //!
     //! \brief addIntN Добавить N-битное значение
@@ -261,6 +427,12 @@ class CsMessageOut
     //!
     void addInt32( int val );
 
+    //!
+    //! \brief addInt64 Добавить 64-битное значение (например, штамп времени)
+    //! \param val 64-битное значение
+    //!
+    void addInt64( int64_t val );
+
     //!
     //! \brief addFloat Добавить 32-битное с плавающей точкой
     //! \param val      32-битное с плавающей точкой
@@ -286,6 +458,21 @@ class CsMessageOut
     //!
     void beginAnswer();
 
+    //!
+    //! \brief beginTaggedQuery Инициализация буфера командой cmd с меткой. После инициализации можно добавлять данные
+    //! \param cmd              Формируемая команда
+    //! \param id               Идентификатор устройства, которому адресована данная команда
+    //! \param seq              Номер запроса (0-7)
+    //!
+    void beginTaggedQuery( char cmd, int id, int seq );
+
+    //!
+    //! \brief beginTaggedAnswer Инициализация буфера для ответа с меткой. После инициализации можно добавлять данные
+    //! \param id                Идентификатор отвечающего устройства
+    //! \param seq               Номер запроса, на который формируется ответ
+    //!
+    void beginTaggedAnswer( int id, int seq );
+
     //!
     //! \brief hostBeginQuery Инициализация буфера командой cmd. После инициализации можно добавлять данные
     //! \param cmd            Формируемая команда
@@ -336,6 +523,13 @@ class CsMessageOut
     //!
     void     makeAnswerControl( int angle, int moment );
 
+    //!
+    //! \brief makeQueryControlNoAnswer Сформировать команду "Управление без ответа"
+    //! \param id                       Идентификатор устройства
+    //! \param value                    Значение управления
+    //!
+    void     makeQueryControlNoAnswer( int id, int value );
+
     //!
     //! \brief makeQueryInfo Сформировать команду "Получить информацию"
     //! \param id            Идентификатор устройства
@@ -364,6 +558,13 @@ class CsMessageOut
     //!
     void     makeAnswerWrite( int value );
 
+    //!
+    //! \brief makeQueryWriteAll Сформировать команду "Запись параметра" во все устройства. Устройства не отвечают
+    //! \param index             Индекс параметра
+    //! \param value             Значение параметра
+    //!
+    void     makeQueryWriteAll( int index, int value ) { makeQueryWrite( CS_ID_BROADCAST, index, value ); }
+
     //!
     //! \brief makeQueryRead Сформировать команду "Чтение параметра"
     //! \param id            Идентификатор устройства
@@ -395,10 +596,455 @@ class CsMessageOut
     //! \param size Размер данных в байтах
     //! \return     Контрольная сумма
     //!
-    static int  crc( const char *buf0, int size0, const char *buf1 = nullptr, int size1 = 0 );
+    static int  crc( const char *buf0, int size0, const char *buf1 = nullptr, int size1 = 0 ) { return csMessageCrc( buf0, size0, buf1, size1 ); }
   };
 
 
+
+//!
+//! \brief addIntN Добавить N-битное значение
+//! \param val     Значение
+//! \param bits    Количество бит значения
+//!
+template <int capacity>
+void CsMessageOutT<capacity>::addIntN(int val, int bits)
+  {
+  //Начальная часть
+  val &= 0xffffffffu >> (32 - bits);
+  //Добавляем биты в текущий байт
+  mBuffer[mPtr] |= (val << mUsedBits) | 0x80;
+
+  //Количество битов добавленных выше
+  int appendedBits = (bits < 7 ? bits : 7) - mUsedBits;
+  val >>= appendedBits;
+  bits -= appendedBits;
+
+  mUsedBits += appendedBits;
+  if( mUsedBits >= 7 ) {
+    mUsedBits = 0;
+    mPtr++;
+    }
+
+  //Целая часть
+  while( bits > 7 ) {
+    mBuffer[mPtr++] = val | 0x80;
+    val >>= 7;
+    bits -= 7;
+    }
+
+  //Заключительная часть
+  if( bits ) {
+    mUsedBits = bits;
+    mBuffer[mPtr] = (val & (0xff >> (8 - bits))) | 0x80;
+    }
+  }
+
+
+
+//!
+//! \brief addInt8 Добавить 8-битное значение
+//! \param val 8-битное значение
+//!
+template <int capacity>
+void CsMessageOutT<capacity>::addInt8(int val)
+  {
+  //Добавляем биты в текущий байт
+  mBuffer[mPtr++] |= (val << mUsedBits) | 0x80;
+
+  //Количество битов добавленных выше
+  int bits = 7 - mUsedBits;
+
+  //Количество использованных битов в новом байте
+  mUsedBits = 8 - bits;
+  mBuffer[mPtr] = ((val & 0xff) >> bits) | 0x80;
+  if( mUsedBits == 7 ) {
+    mPtr++;
+    mBuffer[mPtr] = 0;
+    mUsedBits = 0;
+    }
+  }
+
+
+
+//!
+//! \brief addInt16 Добавить 16-битное значение
+//! \param val 16-битное значение
+//!
+template <int capacity>
+void CsMessageOutT<capacity>::addInt16(int val)
+  {
+  addInt8(val);
+  addInt8(val >> 8);
+  }
+
+
+
+
+//!
+//! \brief addInt32 Добавить 32-битное значение
+//! \param val 32-битное значение
+//!
+template <int capacity>
+void CsMessageOutT<capacity>::addInt32(int val)
+  {
+  addInt8(val);
+  addInt8(val >> 8);
+  addInt8(val >> 16);
+  addInt8(val >> 24);
+  }
+
+
+
+
+
+//!
+//! \brief addInt64 Добавить 64-битное значение (например, штамп времени)
+//! \param val 64-битное значение
+//!
+template <int capacity>
+void CsMessageOutT<capacity>::addInt64(int64_t val)
+  {
+  addInt32( static_cast<int>(val) );
+  addInt32( static_cast<int>(val >> 32) );
+  }
+
+
+
+
+//!
+//! \brief addFloat Добавить 32-битное с плавающей точкой
+//! \param val      32-битное с плавающей точкой
+//!
+template <int capacity>
+void CsMessageOutT<capacity>::addFloat(float val)
+  {
+  addInt32( floatToUInt(val) );
+  }
+
+
+
+
+//!
+//! \brief addBlock Добавить блок байтов
+//! \param block    Блок байтов
+//! \param size     Размер блока
+//!
+template <int capacity>
+void CsMessageOutT<capacity>::addBlock(const char *block, int size)
+  {
+  while( size-- )
+    addInt8( *block++ );
+  }
+
+
+
+
+//!
+//! \brief beginQuery Инициализация буфера командой cmd. После инициализации можно добавлять данные
+//! \param cmd        Формируемая команда
+//! \param id         Идентификатор устройства, которому адресована данная команда
+//!
+template <int capacity>
+void CsMessageOutT<capacity>::beginQuery(char cmd, int id)
+  {
+  mUsedBits = 0;
+  mPtr = 1;
+  mBuffer[0] = ((cmd << 4) & 0x70) | (id & 0xf);
+  mBuffer[1] = 0;
+  }
+
+
+
+//!
+//! \brief beginAnswer Инициализация буфера для ответа. После инициализации можно добавлять данные
+//!
+template <int capacity>
+void CsMessageOutT<capacity>::beginAnswer()
+  {
+  mUsedBits = 0;
+  mPtr = 0;
+  mBuffer[0] = 0;
+  }
+
+
+
+
+//!
+//! \brief beginTaggedQuery Инициализация буфера командой cmd с меткой. После инициализации можно добавлять данные
+//! \param cmd              Формируемая команда
+//! \param id               Идентификатор устройства, которому адресована данная команда
+//! \param seq              Номер запроса (0-7)
+//!
+template <int capacity>
+void CsMessageOutT<capacity>::beginTaggedQuery(char cmd, int id, int seq)
+  {
+  beginQuery( cmd, id );
+  mBuffer[1] = csMessageTag( id, seq );
+  mPtr = 2;
+  mBuffer[2] = 0;
+  }
+
+
+
+
+//!
+//! \brief beginTaggedAnswer Инициализация буфера для ответа с меткой. После инициализации можно добавлять данные
+//! \param id                Идентификатор отвечающего устройства
+//! \param seq               Номер запроса, на который формируется ответ
+//!
+template <int capacity>
+void CsMessageOutT<capacity>::beginTaggedAnswer(int id, int seq)
+  {
+  mUsedBits = 0;
+  mPtr = 1;
+  mBuffer[0] = csMessageTag( id, seq );
+  mBuffer[1] = 0;
+  }
+
+
+
+
+//!
+//! \brief hostBeginQuery Инициализация буфера командой cmd. После инициализации можно добавлять данные
+//! \param cmd            Формируемая команда
+//!
+template <int capacity>
+void CsMessageOutT<capacity>::hostBeginQuery(char cmd)
+  {
+  mUsedBits = 0;
+  mPtr = 1;
+  mBuffer[0] = ((cmd) & 0x7f);
+  mBuffer[1] = 0;
+  }
+
+
+
+
+//!
+//! \brief hostEnd Завершение формирования команды, дописывание контрольной суммы и символа \n
+//!
+template <int capacity>
+void CsMessageOutT<capacity>::hostEnd()
+  {
+  //Завершаем и КС
+  end();
+  mBuffer[mPtr++] = '\n';
+  mBuffer[mPtr] = 0;
+  }
+
+
+
+
+//!
+//! \brief end Завершение формирования команды и дописывание контрольной суммы
+//!
+template <int capacity>
+void CsMessageOutT<capacity>::end()
+  {
+  if( mUsedBits ) mPtr++;
+  mBuffer[mPtr] = crc( mBuffer, mPtr ) | 0x80;
+  mBuffer[++mPtr] = 0;
+  }
+
+
+
+//!
+//! \brief makeQueryControl Сформировать команду "Управление"
+//! \param id               Идентификатор устройства
+//! \param value            Значение управления
+//!
+template <int capacity>
+void CsMessageOutT<capacity>::makeQueryControl(int id, int value)
+  {
+  static_assert( capacity > csCmdLengths[CS_CMD_MSG_CONTROL], "Размер буфера меньше длины сообщения" );
+  beginQuery( CS_CMD_MSG_CONTROL, id );
+  addInt16( value );
+  end();
+  }
+
+
+
+
+//!
+//! \brief makeAnswerControl Сформировать ответ на команду "Управление"
+//! \param angle             Текущий угол сервы
+//! \param moment            Текущий момент
+//!
+template <int capacity>
+void CsMessageOutT<capacity>::makeAnswerControl(int angle, int moment)
+  {
+  static_assert( capacity > csAnswerLengths[CS_CMD_MSG_CONTROL], "Размер буфера меньше длины сообщения" );
+  beginAnswer();
+  addInt16( angle );
+  addInt16( moment );
+  end();
+  }
+
+
+
+
+//!
+//! \brief makeQueryControlNoAnswer Сформировать команду "Управление без ответа"
+//! \param id                       Идентификатор устройства
+//! \param value                    Значение управления
+//!
+template <int capacity>
+void CsMessageOutT<capacity>::makeQueryControlNoAnswer(int id, int value)
+  {
+  static_assert( capacity > csCmdLengths[CS_CMD_MSG_CONTROL_NA], "Размер буфера меньше длины сообщения" );
+  beginQuery( CS_CMD_MSG_CONTROL_NA, id );
+  addInt16( value );
+  end();
+  }
+
+
+
+
+
+//!
+//! \brief makeQueryInfo Сформировать команду "Получить информацию"
+//! \param id            Идентификатор устройства
+//!
+template <int capacity>
+void CsMessageOutT<capacity>::makeQueryInfo(int id)
+  {
+  static_assert( capacity > csCmdLengths[CS_CMD_MSG_INFO], "Размер буфера меньше длины сообщения" );
+  beginQuery( CS_CMD_MSG_INFO, id );
+  end();
+  }
+
+
+
+//!
+//! \brief makeAnswerInfo  Сформировать ответ на команду "Получить информацию"
+//! \param val0            Значение 0
+//! \param val1            Значение 1
+//! \param val2            Значение 2
+//!
+template <int capacity>
+void CsMessageOutT<capacity>::makeAnswerInfo(int val0, int val1, int val2)
+  {
+  static_assert( capacity > csAnswerLengths[CS_CMD_MSG_INFO], "Размер буфера меньше длины сообщения" );
+  beginAnswer();
+  addInt16( val0 );
+  addInt16( val1 );
+  addInt16( val2 );
+  end();
+  }
+
+
+
+
+
+//!
+//! \brief makeQueryWrite Сформировать команду "Запись параметра"
+//! \param id             Идентификатор устройства
+//! \param index          Индекс параметра
+//! \param value          Значение параметра
+//!
+template <int capacity>
+void CsMessageOutT<capacity>::makeQueryWrite(int id, int index, int value)
+  {
+  static_assert( capacity > csCmdLengths[CS_CMD_MSG_WRITE], "Размер буфера меньше длины сообщения" );
+  beginQuery( CS_CMD_MSG_WRITE, id );
+  addInt16( index );
+  addInt32( value );
+  end();
+  }
+
+
+
+
+//!
+//! \brief makeAnswerWrite Сформировать ответ на команду "Запись параметра"
+//! \param value           Значение, записанное в параметр
+//!
+template <int capacity>
+void CsMessageOutT<capacity>::makeAnswerWrite(int value)
+  {
+  static_assert( capacity > csAnswerLengths[CS_CMD_MSG_WRITE], "Размер буфера меньше длины сообщения" );
+  beginAnswer();
+  addInt32( value );
+  end();
+  }
+
+
+
+
+//!
+//! \brief makeQueryRead Сформировать команду "Чтение параметра"
+//! \param id            Идентификатор устройства
+//! \param index         Индекс параметра
+//!
+template <int capacity>
+void CsMessageOutT<capacity>::makeQueryRead(int id, int index)
+  {
+  static_assert( capacity > csCmdLengths[CS_CMD_MSG_READ], "Размер буфера меньше длины сообщения" );
+  beginQuery( CS_CMD_MSG_READ, id );
+  addInt16( index );
+  end();
+
+//  mBuffer[0] = 0xff;
+//  mBuffer[1] = 0xfe;
+////  mBuffer[2] = 0xfc;
+//  mPtr = 2;
+  }
+
+
+
+
+//!
+//! \brief makeAnswerRead Сформировать ответ на команду "Чтение параметра"
+//! \param index          Индекс параметра
+//! \param value          Значение параметра
+//!
+template <int capacity>
+void CsMessageOutT<capacity>::makeAnswerRead(int value)
+  {
+  static_assert( capacity > csAnswerLengths[CS_CMD_MSG_READ], "Размер буфера меньше длины сообщения" );
+  beginAnswer();
+  //addInt16( index );
+  addInt32( value );
+  end();
+  }
+
+
+
+
+//!
+//! \brief makeQueryFlash Сформировать команду "Прошивка"
+//! \param id             Идентификатор устройства
+//! \param adrOrCmd       Адрес прошивки или команда
+//! \param value          Значение прошивки
+//!
+template <int capacity>
+void CsMessageOutT<capacity>::makeQueryFlash(int id, int adrOrCmd, int value)
+  {
+  static_assert( capacity > csCmdLengths[CS_CMD_MSG_FLASH], "Размер буфера меньше длины сообщения" );
+  beginQuery( CS_CMD_MSG_FLASH, id );
+  addInt32(adrOrCmd);
+  addInt32(value);
+  end();
+  }
+
+
+
+
+//Кодировщик общего назначения
+using CsMessageOut    = CsMessageOutT<64>;
+
+//Кодировщик для передачи блоков данных
+using CsMessageOut256 = CsMessageOutT<256>;
+
+//Кодировщик запроса команды cmd минимального размера (с местом для байта метки)
+template <int cmd>
+using CsQueryOut      = CsMessageOutT<csCmdLengths[cmd] + 2>;
+
+//Кодировщик ответа на команду cmd минимального размера (с местом для байта метки)
+template <int cmd>
+using CsAnswerOut     = CsMessageOutT<csAnswerLengths[cmd] + 2>;
+
+
 template <int len>
 struct CsMessageBuf {
     const int mSize = len;  //!< Константный размер буфера
@@ -433,7 +1079,7 @@ class CsMessageIn {
     //! \brief SvTextStreamIn Конструктор декодера
     //! \param buf Буфер, содержащий исходную строку
     //!
-    CsMessageIn( const char *buf, short start, short size = 0x7fff, int ptr = 0 );
+    CsMessageIn( const char *buf, int start, int size = 0x7fff, int ptr = 0 );
 
     template <class CsMessageBufTmpl>
     CsMessageIn( CsMessageBufTmpl &buf, int ptr = 0 ) : mBuffer(buf.mBuffer), mStart(0), mBufSize(buf.mSize), mPtr(ptr), mUsedBits(0) { }
@@ -493,6 +1139,12 @@ class CsMessageIn {
     //!
     int   getInt32();
 
+    //!
+    //! \brief getInt64 Извлекает 64-битное число
+    //! \return 64-битное число
+    //!
+    int64_t getInt64();
+
     //!
     //! \brief getBlock Извлекает набор байтов
     //! \param dest Буфер-приемник байтов
@@ -512,27 +1164,263 @@ class CsMessageIn {
 
 
 //!
-//! \brief floatToUInt Упаковка числа с плавающей точкой в тридцатидвухразрядную ячейку
-//! \param val         Число с плавающей точкой
-//! \return            Упакованное число с плавающей точкой
+//! \brief The CsFrame class не владеющее представление принятого запроса в циклическом буфере.
+//! Хранит только положение и длину запроса, данные не копируются. Отдельные поля декодируются
+//! при обращении по известному смещению в битах (CS_BIT_...) без последовательного разбора,
+//! поэтому фильтрация и маршрутизация читают только нужные байты.
+//! Для ответа (без заголовка) номер первого байта данных равен 0.
 //!
-inline uint32_t floatToUInt( float val )
-  {
-  // We need to do this in order to access the bits from our float
-  uint32_t *u = reinterpret_cast<uint32_t*>(&val);
-  return *u;
-  }
+class CsFrame {
+    const char *mBuffer;  //!< Указатель на циклический буфер
+    int         mBufSize; //!< Размер циклического буфера
+    int         mStart;   //!< Индекс заголовка запроса в циклическом буфере
+    int         mLength;  //!< Полная длина запроса, включая КС
+    int         mData;    //!< Номер первого байта данных (2 для запроса с меткой)
+  public:
+    CsFrame() : mBuffer(nullptr), mBufSize(0), mStart(0), mLength(0), mData(1) {}
+    CsFrame( const char *buf, int bufSize, int start, int length, int data = 1 ) : mBuffer(buf), mBufSize(bufSize), mStart(start), mLength(length), mData(data) {}
+
+    //!
+    //! \brief at    Возвращает байт запроса с учетом циклического буфера
+    //! \param index Номер байта относительно начала запроса
+    //! \return      Байт запроса
+    //!
+    char  at( int index ) const { index += mStart; return mBuffer[ index < mBufSize ? index : index - mBufSize ]; }
+
+    //!
+    //! \brief header Возвращает байт заголовка запроса
+    //! \return       Байт заголовка
+    //!
+    char  header() const { return mBuffer[mStart]; }
+
+    //!
+    //! \brief id Возвращает идентификатор устройства, которому адресован запрос
+    //! \return   Идентификатор устройства
+    //!
+    int   id() const { return csMessageId( header() ); }
+
+    //!
+    //! \brief cmd Возвращает команду запроса
+    //! \return    Команда запроса
+    //!
+    int   cmd() const { return csMessageCmd( header() ); }
+
+    //!
+    //! \brief seq Возвращает номер запроса с меткой
+    //! \return    Номер запроса или -1, если запрос без метки
+    //!
+    int   seq() const { return mData > 1 ? csTagSeq( at(1) ) : -1; }
+
+    //!
+    //! \brief start Возвращает индекс заголовка запроса в циклическом буфере
+    //! \return      Индекс заголовка
+    //!
+    int   start() const { return mStart; }
+
+    //!
+    //! \brief length Возвращает полную длину запроса, включая КС
+    //! \return       Длина запроса
+    //!
+    int   length() const { return mLength; }
+
+    //!
+    //! \brief data Возвращает номер первого байта данных
+    //! \return     Номер байта относительно начала запроса (ответа)
+    //!
+    int   data() const { return mData; }
+
+    //!
+    //! \brief decoder Возвращает декодер, установленный на первый байт данных запроса
+    //! \return        Декодер запроса
+    //!
+    CsMessageIn decoder() const { return CsMessageIn( mBuffer, mStart, mBufSize, mData ); }
+
+    //!
+    //! \brief bitsAt Извлекает поле по смещению в битах от начала данных
+    //! \param bit    Смещение поля в битах (CS_BIT_...)
+    //! \param width  Ширина поля в битах (не более 32)
+    //! \return       Значение поля без знака
+    //!
+    uint32_t bitsAt( int bit, int width ) const
+      {
+      //Каждый байт данных несет 7 бит, младшие биты передаются первыми
+      int      index = mData + bit / 7;
+      int      shift = bit % 7;
+      uint64_t word  = 0;
+      for( int got = 0; got < shift + width; got += 7, index++ )
+        word |= static_cast<uint64_t>( at(index) & 0x7f ) << got;
+      return static_cast<uint32_t>( (word >> shift) & (0xffffffffu >> (32 - width)) );
+      }
+
+    //!
+    //! \brief getUInt16At Извлекает 16-битное число без знака по смещению в битах
+    //! \param bit         Смещение поля в битах (CS_BIT_...)
+    //! \return            16-битное число
+    //!
+    int   getUInt16At( int bit ) const { return bitsAt( bit, 16 ); }
+
+    //!
+    //! \brief getInt16At Извлекает 16-битное число со знаком по смещению в битах
+    //! \param bit        Смещение поля в битах (CS_BIT_...)
+    //! \return           16-битное число со знаком
+    //!
+    int   getInt16At( int bit ) const { return static_cast<int16_t>( bitsAt( bit, 16 ) ); }
+
+    //!
+    //! \brief getInt32At Извлекает 32-битное число по смещению в битах
+    //! \param bit        Смещение поля в битах (CS_BIT_...)
+    //! \return           32-битное число
+    //!
+    int   getInt32At( int bit ) const { return static_cast<int32_t>( bitsAt( bit, 32 ) ); }
+  };
+
+
+
 
 //!
-//! \brief floatFromUInt Распаковка из тридцатидвухразрядной ячейки в число с плавающей точкой
-//! \param val           Упакованное число с плавающей точкой
-//! \return              Число с плавающей точкой
+//! \brief The CsFrameScanner class выделяет запросы из принятых данных циклического буфера.
+//! Поиск ведется по заголовку (старший бит 0), длина берется из CS_CMD_LENGHTS.
+//! Запрос, прерванный следующим заголовком или с несовпавшей КС, пропускается.
+//! Неполный запрос в конце данных остается непрочитанным до поступления остальных байтов.
 //!
-inline float    floatFromUInt( uint32_t val )
+//! Использование:
+//!   CsFrameScanner scan = csFrames( ring, head, tail );
+//!   for( auto frame : scan ) { ... }
+//!   head = scan.head();
+//!
+class CsFrameScanner {
+    const char *mBuffer;  //!< Указатель на циклический буфер
+    int         mBufSize; //!< Размер циклического буфера
+    int         mHead;    //!< Индекс первого непрочитанного байта
+    int         mAvail;   //!< Количество непрочитанных байтов
+    int         mReserve; //!< Количество последних байтов, используемых только для дочитывания запросов
+    int         mErrors;  //!< Количество пропущенных запросов с ошибкой КС
+    uint16_t    mTagged;  //!< Маска устройств, запросы к которым передаются с меткой
+    CsFrame     mFrame;   //!< Текущий выделенный запрос
+
+    char  at( int index ) const { index += mHead; return mBuffer[ index < mBufSize ? index : index - mBufSize ]; }
+
+    void  skip( int count ) { mHead += count; if( mHead >= mBufSize ) mHead -= mBufSize; mAvail -= count; }
+  public:
+    //!
+    //! \brief CsFrameScanner Конструктор выделителя запросов
+    //! \param buf            Циклический буфер
+    //! \param bufSize        Размер циклического буфера
+    //! \param head           Индекс первого непрочитанного байта
+    //! \param avail          Количество непрочитанных байтов
+    //! \param tagged         Маска устройств, запросы к которым передаются с меткой (режим CS_CB_TAGGED_ANSWERS)
+    //!
+    CsFrameScanner( const char *buf, int bufSize, int head, int avail, uint16_t tagged = 0 ) :
+      mBuffer(buf), mBufSize(bufSize), mHead(head), mAvail(avail), mReserve(0), mErrors(0), mTagged(tagged) {}
+
+    //!
+    //! \brief setLimit Ограничить разбор запросами (и ошибками КС), заголовок которых находится
+    //! в первых limit непрочитанных байтах. Остальные байты используются только для дочитывания
+    //! этих запросов. Нужно при разборе данных по частям с перекрытием
+    //! \param limit    Количество байтов, в которых ищутся заголовки
+    //!
+    void  setLimit( int limit ) { mReserve = mAvail > limit ? mAvail - limit : 0; }
+
+    //!
+    //! \brief next  Выделяет очередной запрос
+    //! \param frame Приемник выделенного запроса
+    //! \return      true, если запрос выделен, false - если полных запросов больше нет
+    //!
+    bool  next( CsFrame &frame )
+      {
+      while( mAvail > mReserve ) {
+        char ch = at(0);
+        int len;
+        //Пропускаем байты данных и зарезервированные команды
+        if( (ch & 0x80) || (len = csMessageLength(ch)) == 0 ) {
+          skip(1);
+          continue;
+          }
+        int tag = csTagLength( mTagged, csMessageId(ch) );
+        len += tag;
+        //Все байты данных должны иметь старший бит 1, иначе запрос прерван
+        int i = 1;
+        while( i < len && i < mAvail && (at(i) & 0x80) ) i++;
+        //Запрос еще не принят полностью
+        if( i == mAvail && i < len )
+          return false;
+        if( i < len ) {
+          skip(i);
+          continue;
+          }
+        if( !CsMessageIn( mBuffer, mHead, mBufSize ).checkCrc( len ) ) {
+          mErrors++;
+          skip(1);
+          continue;
+          }
+        frame = CsFrame( mBuffer, mBufSize, mHead, len, 1 + tag );
+        skip(len);
+        return true;
+        }
+      return false;
+      }
+
+    //!
+    //! \brief head Возвращает индекс первого непрочитанного байта
+    //! \return     Индекс, с которого нужно продолжить разбор после поступления новых данных
+    //!
+    int   head() const { return mHead; }
+
+    //!
+    //! \brief errors Возвращает количество пропущенных запросов с ошибкой КС
+    //! \return       Количество ошибок КС
+    //!
+    int   errors() const { return mErrors; }
+
+    //Поддержка цикла for по диапазону
+    class iterator {
+        CsFrameScanner *mScanner;
+        bool            mValid;
+      public:
+        iterator( CsFrameScanner *scanner ) : mScanner(scanner), mValid(scanner && scanner->next(scanner->mFrame)) {}
+        const CsFrame &operator * () const { return mScanner->mFrame; }
+        iterator      &operator ++ () { mValid = mScanner->next(mScanner->mFrame); return *this; }
+        bool           operator != ( const iterator &it ) const { return mValid != it.mValid; }
+      };
+
+    iterator begin() { return iterator(this); }
+    iterator end() { return iterator(nullptr); }
+  };
+
+
+
+//!
+//! \brief csFrames Создает выделитель запросов для циклического буфера
+//! \param buf      Циклический буфер
+//! \param bufSize  Размер циклического буфера
+//! \param head     Индекс первого непрочитанного байта
+//! \param tail     Индекс, по которому будет записан следующий принятый байт
+//! \param tagged   Маска устройств, запросы к которым передаются с меткой
+//! \return         Выделитель запросов
+//!
+inline CsFrameScanner csFrames( const char *buf, int bufSize, int head, int tail, uint16_t tagged = 0 )
   {
-  float *f = reinterpret_cast<float*>(&val);
-  return *f;
+  int avail = tail - head;
+  return CsFrameScanner( buf, bufSize, head, avail < 0 ? avail + bufSize : avail, tagged );
   }
 
+//!
+//! \brief csFrames Создает выделитель запросов для буфера CsMessageBuf, используемого как циклический
+//! \param buf      Буфер
+//! \param head     Индекс первого непрочитанного байта
+//! \param tail     Индекс, по которому будет записан следующий принятый байт
+//! \return         Выделитель запросов
+//!
+template <class CsMessageBufTmpl>
+inline CsFrameScanner csFrames( const CsMessageBufTmpl &buf, int head, int tail ) { return csFrames( buf.mBuffer, buf.mSize, head, tail ); }
+
+//!
+//! \brief csFrames Создает выделитель запросов для линейно заполненного буфера CsMessageBuf
+//! \param buf      Буфер, содержащий mLength принятых байтов
+//! \return         Выделитель запросов
+//!
+template <class CsMessageBufTmpl>
+inline CsFrameScanner csFrames( const CsMessageBufTmpl &buf ) { return CsFrameScanner( buf.mBuffer, buf.mSize, 0, buf.mLength ); }
+
 
 #endif // CSMESSAGE_H
@@ -0,0 +1,244 @@
+#include "CsAllocGuard.hpp"
+
+#include <errno.h>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __GLIBC__
+#include <execinfo.h>
+#include <unistd.h>
+#endif
+
+//Состояние контроля выделений одного потока
+struct CsAllocState {
+    bool     mArmed;                                 //!< Контроль включен
+    bool     mInHook;                                //!< Защита от повторного входа при сохранении стека
+    uint64_t mCount;                                 //!< Количество выделений после включения контроля
+    int      mDepth[CS_ALLOC_STACKS];                //!< Глубина сохраненных стеков
+    void    *mStacks[CS_ALLOC_STACKS][CS_ALLOC_DEPTH]; //!< Сохраненные стеки вызовов
+  };
+
+static thread_local CsAllocState csAllocState;
+
+
+
+//!
+//! \brief csAllocHook Учет выделения памяти
+//!
+static void csAllocHook()
+  {
+  CsAllocState &st = csAllocState;
+  if( !st.mArmed || st.mInHook ) return;
+  st.mInHook = true;
+  if( st.mCount < CS_ALLOC_STACKS ) {
+#ifdef __GLIBC__
+    st.mDepth[st.mCount] = backtrace( st.mStacks[st.mCount], CS_ALLOC_DEPTH );
+#else
+    st.mDepth[st.mCount] = 0;
+#endif
+    }
+  st.mCount++;
+  st.mInHook = false;
+  }
+
+
+
+
+//!
+//! \brief csAllocArm Начать контроль выделений памяти в текущем потоке
+//!
+void csAllocArm()
+  {
+#ifdef __GLIBC__
+  //Первый вызов backtrace загружает libgcc и сам выделяет память - делаем его заранее
+  void *frames[1];
+  backtrace( frames, 1 );
+#endif
+  csAllocState.mCount = 0;
+  csAllocState.mArmed = true;
+  }
+
+
+
+
+//!
+//! \brief csAllocDisarm Завершить контроль выделений памяти в текущем потоке
+//! \return              Количество выделений с момента csAllocArm
+//!
+uint64_t csAllocDisarm()
+  {
+  csAllocState.mArmed = false;
+  return csAllocState.mCount;
+  }
+
+
+
+
+//!
+//! \brief csAllocCount Возвращает количество выделений памяти в текущем потоке с момента csAllocArm
+//! \return             Количество выделений
+//!
+uint64_t csAllocCount()
+  {
+  return csAllocState.mCount;
+  }
+
+
+
+
+//!
+//! \brief csAllocReport Вывести стеки вызовов выделений памяти текущего потока
+//! \param fd            Дескриптор файла для вывода
+//!
+void csAllocReport(int fd)
+  {
+  CsAllocState &st = csAllocState;
+  int stacks = st.mCount < CS_ALLOC_STACKS ? static_cast<int>(st.mCount) : CS_ALLOC_STACKS;
+  for( int i = 0; i < stacks; i++ ) {
+    char title[64];
+    int len = snprintf( title, sizeof(title), "allocation %d:\n", i );
+#ifdef __GLIBC__
+    if( write( fd, title, len ) < 0 ) return;
+    //backtrace_symbols_fd не выделяет память
+    backtrace_symbols_fd( st.mStacks[i], st.mDepth[i], fd );
+#else
+    (void)fd;
+    (void)len;
+#endif
+    }
+  }
+
+
+
+
+#ifdef __GLIBC__
+//Замещение функций выделения памяти библиотеки C. Исходные реализации glibc
+//доступны под именами __libc_*, поэтому dlsym не требуется. Сюда же попадают
+//выделения внутри libc и libstdc++ (strdup, operator new и т.п.).
+extern "C" {
+void *__libc_malloc( size_t size );
+void *__libc_calloc( size_t count, size_t size );
+void *__libc_realloc( void *ptr, size_t size );
+void *__libc_memalign( size_t alignment, size_t size );
+void  __libc_free( void *ptr );
+
+void *malloc( size_t size )
+  {
+  csAllocHook();
+  return __libc_malloc( size );
+  }
+
+void *calloc( size_t count, size_t size )
+  {
+  csAllocHook();
+  return __libc_calloc( count, size );
+  }
+
+void *realloc( void *ptr, size_t size )
+  {
+  //realloc( ptr, 0 ) только освобождает память
+  if( ptr == nullptr || size != 0 ) csAllocHook();
+  return __libc_realloc( ptr, size );
+  }
+
+void *memalign( size_t alignment, size_t size )
+  {
+  csAllocHook();
+  return __libc_memalign( alignment, size );
+  }
+
+void *aligned_alloc( size_t alignment, size_t size )
+  {
+  csAllocHook();
+  return __libc_memalign( alignment, size );
+  }
+
+int posix_memalign( void **ptr, size_t alignment, size_t size )
+  {
+  if( alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0 ) return EINVAL;
+  csAllocHook();
+  void *mem = __libc_memalign( alignment, size );
+  if( mem == nullptr ) return ENOMEM;
+  *ptr = mem;
+  return 0;
+  }
+
+void free( void *ptr )
+  {
+  __libc_free( ptr );
+  }
+}
+
+//Выделения operator new учитываются в malloc и posix_memalign
+static inline void csNewHook() {}
+#else
+//Без glibc учитываются только выделения operator new
+static inline void csNewHook() { csAllocHook(); }
+#endif
+
+
+
+
+//Замещение глобальных операторов выделения памяти
+static void *csAllocate( size_t size )
+  {
+  csNewHook();
+  void *ptr = malloc( size ? size : 1 );
+  if( ptr == nullptr ) throw std::bad_alloc();
+  return ptr;
+  }
+
+void *operator new( size_t size ) { return csAllocate( size ); }
+
+void *operator new[]( size_t size ) { return csAllocate( size ); }
+
+void *operator new( size_t size, const std::nothrow_t & ) noexcept { csNewHook(); return malloc( size ? size : 1 ); }
+
+void *operator new[]( size_t size, const std::nothrow_t & ) noexcept { csNewHook(); return malloc( size ? size : 1 ); }
+
+void operator delete( void *ptr ) noexcept { free( ptr ); }
+
+void operator delete[]( void *ptr ) noexcept { free( ptr ); }
+
+void operator delete( void *ptr, size_t ) noexcept { free( ptr ); }
+
+void operator delete[]( void *ptr, size_t ) noexcept { free( ptr ); }
+
+//Выровненные формы (объекты с alignas больше __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+static void *csAllocateAligned( size_t size, std::align_val_t align ) noexcept
+  {
+  csNewHook();
+  size_t alignment = static_cast<size_t>(align);
+  if( alignment < sizeof(void*) ) alignment = sizeof(void*);
+  void *ptr = nullptr;
+  if( posix_memalign( &ptr, alignment, size ? size : 1 ) != 0 ) return nullptr;
+  return ptr;
+  }
+
+void *operator new( size_t size, std::align_val_t align )
+  {
+  void *ptr = csAllocateAligned( size, align );
+  if( ptr == nullptr ) throw std::bad_alloc();
+  return ptr;
+  }
+
+void *operator new[]( size_t size, std::align_val_t align )
+  {
+  void *ptr = csAllocateAligned( size, align );
+  if( ptr == nullptr ) throw std::bad_alloc();
+  return ptr;
+  }
+
+void *operator new( size_t size, std::align_val_t align, const std::nothrow_t & ) noexcept { return csAllocateAligned( size, align ); }
+
+void *operator new[]( size_t size, std::align_val_t align, const std::nothrow_t & ) noexcept { return csAllocateAligned( size, align ); }
+
+void operator delete( void *ptr, std::align_val_t ) noexcept { free( ptr ); }
+
+void operator delete[]( void *ptr, std::align_val_t ) noexcept { free( ptr ); }
+
+void operator delete( void *ptr, size_t, std::align_val_t ) noexcept { free( ptr ); }
+
+void operator delete[]( void *ptr, size_t, std::align_val_t ) noexcept { free( ptr ); }
@@ -0,0 +1,71 @@
+#include "CsBatchDecode.hpp"
+
+
+//!
+//! \brief csGatherPayload Собрать полезные 7-битные группы ответов в 64-битные слова
+//! \param frames          Ответы
+//! \param count           Количество ответов
+//! \param groups          Количество 7-битных групп в ответе
+//! \param words           Массив слов
+//!
+static void csGatherPayload( const CsFrame *frames, int count, int groups, uint64_t *words )
+  {
+  for( int i = 0; i < count; i++ ) {
+    //Ответ с меткой начинается с байта метки, данные следуют за ним
+    int      data = frames[i].data();
+    uint64_t word = 0;
+    for( int g = 0; g < groups; g++ )
+      word |= static_cast<uint64_t>( frames[i].at(data + g) & 0x7f ) << (7 * g);
+    words[i] = word;
+    }
+  }
+
+
+
+
+//!
+//! \brief csDecodeControlAnswers Декодировать ответы на команду "Управление"
+//! \param frames                 Проверенные ответы
+//! \param count                  Количество ответов
+//! \param angles                 Массив текущих углов
+//! \param moments                Массив текущих моментов
+//!
+void csDecodeControlAnswers(const CsFrame *frames, int count, int16_t *angles, int16_t *moments)
+  {
+  uint64_t words[CS_BATCH_BLOCK];
+  for( int base = 0; base < count; base += CS_BATCH_BLOCK ) {
+    int n = count - base < CS_BATCH_BLOCK ? count - base : CS_BATCH_BLOCK;
+    //Угол и момент - 32 бита, размещенные в 5 группах
+    csGatherPayload( frames + base, n, 5, words );
+    for( int i = 0; i < n; i++ ) {
+      angles[base + i]  = static_cast<int16_t>( words[i] );
+      moments[base + i] = static_cast<int16_t>( words[i] >> 16 );
+      }
+    }
+  }
+
+
+
+
+//!
+//! \brief csDecodeInfoAnswers Декодировать ответы на команду "Получить информацию"
+//! \param frames              Проверенные ответы
+//! \param count               Количество ответов
+//! \param info0               Массив значений 0
+//! \param info1               Массив значений 1
+//! \param info2               Массив значений 2
+//!
+void csDecodeInfoAnswers(const CsFrame *frames, int count, int16_t *info0, int16_t *info1, int16_t *info2)
+  {
+  uint64_t words[CS_BATCH_BLOCK];
+  for( int base = 0; base < count; base += CS_BATCH_BLOCK ) {
+    int n = count - base < CS_BATCH_BLOCK ? count - base : CS_BATCH_BLOCK;
+    //Три значения - 48 бит, размещенные в 7 группах
+    csGatherPayload( frames + base, n, 7, words );
+    for( int i = 0; i < n; i++ ) {
+      info0[base + i] = static_cast<int16_t>( words[i] );
+      info1[base + i] = static_cast<int16_t>( words[i] >> 16 );
+      info2[base + i] = static_cast<int16_t>( words[i] >> 32 );
+      }
+    }
+  }
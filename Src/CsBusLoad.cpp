@@ -0,0 +1,104 @@
+#include "CsBusLoad.hpp"
+
+
+//!
+//! \brief account     Учесть обмен
+//! \param queryEnd    Время окончания запроса, мкс
+//! \param queryBytes  Длина запроса, байт
+//! \param answerBytes Длина ответа, байт, или 0 если ответа нет
+//! \param latency     Время реакции устройства, мкс, или -1 если ответа нет
+//! \param awaited     true - на запрос без метки ожидался ответ, до его получения или
+//!                    истечения времени ожидания следующий запрос не передается
+//! \param corrupted   true - ответ принят с ошибкой КС или прерван: время передачи
+//!                    учитывается, но ответ и время реакции не учитываются
+//!
+void CsBusLoad::account(uint32_t queryEnd, int queryBytes, int answerBytes, int32_t latency, bool awaited, bool corrupted)
+  {
+  int      queryTime = csWireTime( queryBytes, mBaud );
+  uint32_t start     = queryEnd - queryTime;
+  uint32_t end       = queryEnd;
+  mStat.mExchanges++;
+  mStat.mBusyUs += queryTime;
+  if( answerBytes > 0 && latency >= 0 ) {
+    int answerTime = csWireTime( answerBytes, mBaud );
+    end = queryEnd + latency + answerTime;
+    mStat.mBusyUs += answerTime;
+    if( corrupted )
+      mStat.mCorrupted++;
+    else {
+      mStat.mAnswers++;
+      mStat.mTurnaround.add( latency );
+      }
+    awaited = false;
+    }
+  else if( awaited )
+    mStat.mMissing++;
+
+  if( !mStarted ) {
+    mStarted  = true;
+    mAwaiting = awaited;
+    mLineEnd  = end;
+    mStat.mElapsedUs += end - start;
+    return;
+    }
+  //Разности времени со знаком, чтобы учесть переполнение счетчика мкс
+  int32_t gap = static_cast<int32_t>( start - mLineEnd );
+  if( gap >= 0 ) {
+    //После запроса, оставшегося без ответа, линия занята ожиданием до следующего запроса
+    if( mAwaiting ) {
+      int32_t wait = gap < mTimeout ? gap : mTimeout;
+      mStat.mWaitUs += wait;
+      gap -= wait;
+      }
+    mStat.mIdle.add( gap );
+    }
+  mAwaiting = awaited;
+  int32_t advance = static_cast<int32_t>( end - mLineEnd );
+  if( advance > 0 ) {
+    mStat.mElapsedUs += advance;
+    mLineEnd = end;
+    }
+  }
+
+
+
+
+//!
+//! \brief record  Функция обработки пар запрос-ответ анализатора (CsSniffFn)
+//! \param context Учет загрузки шины
+//! \param record  Запрос и ответ
+//!
+void CsBusLoad::record(void *context, const CsSniffRecord &record)
+  {
+  //Ответ на запрос без метки ожидается, если он предусмотрен командой (кроме широковещательной записи)
+  int  cmd     = record.mQuery.cmd();
+  bool awaited = record.mQuery.data() == 1 && csAnswerLengths[cmd] != 0 &&
+                 !(record.mQuery.id() == CS_ID_BROADCAST && cmd == CS_CMD_MSG_WRITE);
+  //Ответ с ошибкой КС передается без кадра, но с количеством принятых байтов
+  bool corrupted = record.mErrorBytes > 0;
+  int  answer    = corrupted ? record.mErrorBytes : record.mAnswer.length();
+  static_cast<CsBusLoad*>(context)->account( record.mTime, record.mQuery.length(), answer, record.mLatency, awaited, corrupted );
+  }
+
+
+
+
+//!
+//! \brief projected Оценить занятость шины после добавления обменов
+//! \param exchanges Количество добавляемых обменов в цикле (например, число устройств)
+//! \param cmd       Команда добавляемых обменов
+//! \param rate      Частота цикла, Гц
+//! \param tagged    true - добавляемые обмены передаются с меткой
+//! \return          Ожидаемая доля времени, занятого обменами (больше 1 - шина перегружена)
+//!
+double CsBusLoad::projected(int exchanges, int cmd, int rate, bool tagged) const
+  {
+  //Время одного добавляемого обмена: запрос, ответ, байты метки и средняя измеренная реакция устройства
+  bool    answered = csAnswerLengths[cmd & 0x7] != 0;
+  int64_t exchange = csExchangeTime( cmd, mBaud );
+  if( tagged )
+    exchange += csWireTime( answered ? 2 : 1, mBaud );
+  if( answered )
+    exchange += mStat.mTurnaround.mean();
+  return mStat.occupancy() + static_cast<double>(exchange) * exchanges * rate / 1000000;
+  }
@@ -0,0 +1,329 @@
+#include "CsBusPort.hpp"
+
+#include <string.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+
+//!
+//! \brief csBaudSpeed Возвращает константу скорости termios
+//! \param baud        Скорость обмена, бод
+//! \return            Константа скорости или B0, если скорость не поддерживается
+//!
+static speed_t csBaudSpeed( int baud )
+  {
+  static const struct { int mBaud; speed_t mSpeed; } speeds[] = {
+    {    9600, B9600 },    {   19200, B19200 },   {   38400, B38400 },   {   57600, B57600 },
+    {  115200, B115200 },  {  230400, B230400 },  {  460800, B460800 },  {  500000, B500000 },
+    {  576000, B576000 },  {  921600, B921600 },  { 1000000, B1000000 }, { 1152000, B1152000 },
+    { 1500000, B1500000 }, { 2000000, B2000000 }, { 2500000, B2500000 }, { 3000000, B3000000 },
+    { 3500000, B3500000 }, { 4000000, B4000000 }
+    };
+  for( auto &s : speeds )
+    if( s.mBaud == baud ) return s.mSpeed;
+  return B0;
+  }
+
+
+
+
+//!
+//! \brief csPortLost Проверить, означает ли ошибка потерю устройства
+//! \param err        Код ошибки errno
+//! \return           true, если устройство отключено
+//!
+static bool csPortLost( int err )
+  {
+  return err == EIO || err == ENODEV || err == ENXIO;
+  }
+
+
+
+
+//!
+//! \brief csPortHangup Проверить без ожидания, сообщает ли порт о разрыве
+//! \param fd           Дескриптор порта
+//! \return             true, если устройство отключено
+//!
+static bool csPortHangup( int fd )
+  {
+  struct pollfd pfd;
+  pfd.fd      = fd;
+  pfd.events  = POLLIN;
+  pfd.revents = 0;
+  return poll( &pfd, 1, 0 ) > 0 && (pfd.revents & (POLLHUP | POLLERR)) != 0;
+  }
+#endif
+
+
+
+
+CsBusPort::CsBusPort() :
+  mFd(-1),
+  mBaud(0),
+  mGeneration(0)
+  {
+  mPath[0] = 0;
+#ifdef __linux__
+  mHaveTermios = false;
+#endif
+  }
+
+
+
+
+//!
+//! \brief open Открыть порт и настроить его на обмен с шиной (8N1, без обработки символов)
+//! \param path Путь к порту, например /dev/ttyUSB0
+//! \param baud Скорость обмена, бод
+//! \return     true при успешном открытии
+//!
+bool CsBusPort::open(const char *path, int baud)
+  {
+  close();
+  strncpy( mPath, path, CS_PORT_PATH_MAX - 1 );
+  mPath[CS_PORT_PATH_MAX - 1] = 0;
+  mBaud = baud;
+#ifdef __linux__
+  mHaveTermios = false;
+  int fd = ::open( mPath, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC );
+  if( fd < 0 ) return false;
+
+  struct termios tio;
+  speed_t speed = csBaudSpeed( baud );
+  if( tcgetattr( fd, &tio ) != 0 || speed == B0 ) {
+    ::close( fd );
+    return false;
+    }
+  cfmakeraw( &tio );
+  tio.c_cflag |= CLOCAL | CREAD;
+  tio.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS);
+  tio.c_cc[VMIN]  = 0;
+  tio.c_cc[VTIME] = 0;
+  cfsetispeed( &tio, speed );
+  cfsetospeed( &tio, speed );
+  if( tcsetattr( fd, TCSANOW, &tio ) != 0 ) {
+    ::close( fd );
+    return false;
+    }
+  tcflush( fd, TCIOFLUSH );
+  mTermios     = tio;
+  mHaveTermios = true;
+  mFd          = fd;
+  mGeneration++;
+  return true;
+#else
+  return false;
+#endif
+  }
+
+
+
+
+//!
+//! \brief reopen Повторно открыть порт с сохраненными настройками
+//! \return       true при успешном открытии
+//!
+bool CsBusPort::reopen()
+  {
+  if( mPath[0] == 0 ) return false;
+#ifdef __linux__
+  if( !mHaveTermios ) return open( mPath, mBaud );
+  close();
+  int fd = ::open( mPath, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC );
+  if( fd < 0 ) return false;
+  //Новое устройство получает настройки по умолчанию - восстанавливаем сохраненные
+  if( tcsetattr( fd, TCSANOW, &mTermios ) != 0 ) {
+    ::close( fd );
+    return false;
+    }
+  tcflush( fd, TCIOFLUSH );
+  mFd = fd;
+  mGeneration++;
+  return true;
+#else
+  return false;
+#endif
+  }
+
+
+
+
+//!
+//! \brief close Закрыть порт
+//!
+void CsBusPort::close()
+  {
+#ifdef __linux__
+  if( mFd >= 0 )
+    ::close( mFd );
+#endif
+  mFd = -1;
+  }
+
+
+
+
+//!
+//! \brief read Прочитать доступные данные без ожидания. При потере устройства порт закрывается
+//! \param dst  Буфер-приемник
+//! \param size Размер буфера
+//! \return     Количество прочитанных байтов, 0 если данных нет, -1 если порт закрыт
+//!
+int CsBusPort::read(char *dst, int size)
+  {
+  if( mFd < 0 ) return -1;
+#ifdef __linux__
+  ssize_t len = ::read( mFd, dst, size );
+  if( len > 0 ) return static_cast<int>(len);
+  //При VMIN = 0 и VTIME = 0 порт без данных возвращает 0 байтов (или EAGAIN), поэтому
+  //потеря устройства определяется только по коду ошибки или по разрыву, о котором сообщает poll
+  if( len < 0 ? !csPortLost( errno ) : !csPortHangup( mFd ) ) return 0;
+#else
+  (void)dst;
+  (void)size;
+#endif
+  close();
+  return -1;
+  }
+
+
+
+
+//!
+//! \brief write Записать данные в порт. При потере устройства порт закрывается
+//! \param data  Данные
+//! \param size  Количество байтов
+//! \return      Количество записанных байтов или -1, если порт закрыт
+//!
+int CsBusPort::write(const char *data, int size)
+  {
+  if( mFd < 0 ) return -1;
+#ifdef __linux__
+  ssize_t len = ::write( mFd, data, size );
+  if( len >= 0 ) return static_cast<int>(len);
+  if( !csPortLost( errno ) ) return 0;
+#else
+  (void)data;
+  (void)size;
+#endif
+  close();
+  return -1;
+  }
+
+
+
+
+//!
+//! \brief name Возвращает имя порта без каталога, например ttyUSB0
+//! \return     Имя порта
+//!
+const char *CsBusPort::name() const
+  {
+  const char *slash = strrchr( mPath, '/' );
+  return slash ? slash + 1 : mPath;
+  }
+
+
+
+
+//!
+//! \brief open Начать слежение
+//! \param dir  Каталог устройств
+//! \return     true при успешном запуске
+//!
+bool CsHotplug::open(const char *dir)
+  {
+  close();
+#ifdef __linux__
+  mFd = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+  if( mFd < 0 ) return false;
+  if( inotify_add_watch( mFd, dir, IN_CREATE | IN_DELETE | IN_ATTRIB ) < 0 ) {
+    close();
+    return false;
+    }
+  return true;
+#else
+  (void)dir;
+  return false;
+#endif
+  }
+
+
+
+
+//!
+//! \brief close Прекратить слежение
+//!
+void CsHotplug::close()
+  {
+#ifdef __linux__
+  if( mFd >= 0 )
+    ::close( mFd );
+#endif
+  mFd = -1;
+  }
+
+
+
+
+//!
+//! \brief read   Прочитать накопленные события без ожидания
+//! \param events Приемник событий
+//! \param max    Максимальное количество событий
+//! \return       Количество прочитанных событий
+//!
+int CsHotplug::read(CsHotplugEvent *events, int max)
+  {
+  int count = 0;
+#ifdef __linux__
+  if( mFd < 0 ) return 0;
+  alignas(struct inotify_event) char buf[4096];
+  while( count < max ) {
+    ssize_t len = ::read( mFd, buf, sizeof(buf) );
+    if( len <= 0 ) break;
+    for( char *ptr = buf; ptr < buf + len && count < max; ) {
+      struct inotify_event *ev = reinterpret_cast<struct inotify_event*>(ptr);
+      ptr += sizeof(struct inotify_event) + ev->len;
+      if( ev->len == 0 ) continue;
+      strncpy( events[count].mName, ev->name, sizeof(events[count].mName) - 1 );
+      events[count].mName[sizeof(events[count].mName) - 1] = 0;
+      events[count].mAdded = (ev->mask & IN_DELETE) == 0;
+      count++;
+      }
+    }
+#else
+  (void)events;
+  (void)max;
+#endif
+  return count;
+  }
+
+
+
+
+//!
+//! \brief csHotplugApply Закрыть порт при исчезновении его устройства и открыть при появлении
+//! \param port           Порт шины
+//! \param events         События CsHotplug
+//! \param count          Количество событий
+//! \return               true, если порт был открыт заново
+//!
+bool csHotplugApply(CsBusPort &port, const CsHotplugEvent *events, int count)
+  {
+  bool reopened = false;
+  for( int i = 0; i < count; i++ ) {
+    if( strcmp( events[i].mName, port.name() ) != 0 ) continue;
+    if( !events[i].mAdded )
+      port.close();
+    //Узел может появиться раньше, чем udev выдаст права доступа - тогда порт откроется по IN_ATTRIB
+    else if( !port.isOpen() && port.reopen() )
+      reopened = true;
+    }
+  return reopened;
+  }
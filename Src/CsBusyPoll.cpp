@@ -0,0 +1,126 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "CsBusyPoll.hpp"
+
+#include <errno.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+
+//!
+//! \brief csCpuPause Подсказка процессору о цикле ожидания
+//!
+static inline void csCpuPause()
+  {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+  __asm__ __volatile__( "yield" );
+#endif
+  }
+
+
+
+
+//!
+//! \brief csClockUs Возвращает показание часов
+//! \param clock     Идентификатор часов
+//! \return          Время, мкс
+//!
+static uint64_t csClockUs( clockid_t clock )
+  {
+  struct timespec ts;
+  clock_gettime( clock, &ts );
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+  }
+
+
+
+
+//!
+//! \brief csTimeUs Возвращает монотонное время
+//! \return         Время, мкс
+//!
+uint32_t csTimeUs()
+  {
+  return static_cast<uint32_t>( csClockUs( CLOCK_MONOTONIC ) );
+  }
+
+
+
+
+//!
+//! \brief run  Выполнять прием до установки признака остановки или ошибки порта.
+//! Если задан mCpu, текущий поток привязывается к этому процессору
+//! \param fd   Дескриптор порта, открытого в неблокирующем режиме
+//! \param stop Признак остановки
+//! \return     true при остановке по признаку, false при ошибке порта
+//!
+bool CsBusyPoll::run(int fd, const std::atomic<bool> &stop)
+  {
+#ifdef __linux__
+  if( mPolicy.mCpu >= 0 ) {
+    cpu_set_t set;
+    CPU_ZERO( &set );
+    CPU_SET( mPolicy.mCpu, &set );
+    pthread_setaffinity_np( pthread_self(), sizeof(set), &set );
+    }
+
+  uint64_t wall0 = csClockUs( CLOCK_MONOTONIC );
+  uint64_t cpu0  = csClockUs( CLOCK_THREAD_CPUTIME_ID );
+  char     block[CS_POLL_BLOCK];
+  uint32_t idle = 0;
+  bool     ok   = true;
+  while( !stop.load( std::memory_order_relaxed ) ) {
+    mStat.mPolls++;
+    ssize_t len = read( fd, block, sizeof(block) );
+    if( len > 0 ) {
+      mHandler( mContext, block, static_cast<int>(len), csTimeUs() );
+      mStat.mBytes += len;
+      //Непрерывный опрос возобновляется только после поступления данных
+      idle = 0;
+      continue;
+      }
+    //0 байтов при VMIN = 0 и VTIME = 0 означает отсутствие данных, разрыв определяется по poll()
+    if( len < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR ) {
+      ok = false;
+      break;
+      }
+
+    //Данных нет: непрерывный опрос, затем уступка процессора, затем ожидание
+    mStat.mEmpty++;
+    if( idle < mPolicy.mSpin )
+      csCpuPause();
+    else if( idle < mPolicy.mSpin + mPolicy.mYield ) {
+      sched_yield();
+      mStat.mYields++;
+      }
+    else {
+      struct pollfd pfd = { fd, POLLIN, 0 };
+      struct timespec timeout = { static_cast<time_t>(mPolicy.mIdleUs / 1000000), static_cast<long>(mPolicy.mIdleUs % 1000000) * 1000 };
+      mStat.mWaits++;
+      if( ppoll( &pfd, 1, &timeout, nullptr ) > 0 && (pfd.revents & (POLLHUP | POLLERR | POLLNVAL)) ) {
+        ok = false;
+        break;
+        }
+      //Без сброса idle: по истечении времени ожидание повторяется, данные прочитает следующий опрос
+      continue;
+      }
+    idle++;
+    }
+  mStat.mWallUs += csClockUs( CLOCK_MONOTONIC ) - wall0;
+  mStat.mCpuUs  += csClockUs( CLOCK_THREAD_CPUTIME_ID ) - cpu0;
+  return ok;
+#else
+  (void)fd;
+  (void)stop;
+  return false;
+#endif
+  }
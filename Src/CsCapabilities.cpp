@@ -0,0 +1,103 @@
+#include "CsCapabilities.hpp"
+
+
+CsCapabilities::CsCapabilities(uint16_t ids, uint16_t allowed) :
+  mAllowed(allowed),
+  mCurrent(-1)
+  {
+  for( int id = 0; id < CS_DEVICE_COUNT; id++ ) {
+    //Универсальный идентификатор не опрашивается
+    mStage[id]   = (id != CS_ID_BROADCAST && (ids & (1 << id))) ? StageVersion : StageAbsent;
+    mVersion[id] = 0;
+    mCaps[id]    = 0;
+    mActive[id]  = 0;
+    }
+  }
+
+
+
+
+//!
+//! \brief answer Обработать ответ на запрос согласования
+//! \param value  Значение из ответа
+//!
+void CsCapabilities::answer(int value)
+  {
+  if( mCurrent < 0 ) return;
+  int id = mCurrent;
+  mCurrent = -1;
+  switch( mStage[id] ) {
+    case StageVersion :
+      mVersion[id] = static_cast<uint32_t>(value);
+      mStage[id]   = StageCaps;
+      break;
+
+    case StageCaps :
+      //Устройства до появления таблицы возможностей не возвращают признак и работают только в классическом режиме
+      mCaps[id]  = ((static_cast<uint32_t>(value) >> 16) == CS_CAP_SIGNATURE) ? static_cast<uint16_t>(value) : 0;
+      mStage[id] = supports( id, CS_CAP_TAGGED_ANSWERS ) ? StageTagged : StageDone;
+      break;
+
+    case StageTagged :
+      //Ответ на запись - записанное значение
+      if( value == 1 )
+        mActive[id] |= CS_CAP_TAGGED_ANSWERS;
+      mStage[id] = StageDone;
+      break;
+
+    default :
+      break;
+    }
+  }
+
+
+
+
+//!
+//! \brief timeout Сообщить об отсутствии ответа на запрос согласования
+//!
+void CsCapabilities::timeout()
+  {
+  if( mCurrent < 0 ) return;
+  int id = mCurrent;
+  mCurrent = -1;
+  //Не ответившее на чтение версии программы устройство отсутствует, на последующие запросы - работает классически
+  if( mStage[id] == StageVersion ) {
+    mStage[id] = StageAbsent;
+    return;
+    }
+  if( mStage[id] == StageCaps )
+    mCaps[id] = 0;
+  mStage[id] = StageDone;
+  }
+
+
+
+
+//!
+//! \brief supportedByAll Возвращает возможности, поддерживаемые всеми обнаруженными устройствами
+//! \return               Маска возможностей
+//!
+uint16_t CsCapabilities::supportedByAll() const
+  {
+  uint16_t caps = mAllowed;
+  for( int id = 0; id < CS_DEVICE_COUNT; id++ )
+    if( present( id ) )
+      caps &= mCaps[id];
+  return caps;
+  }
+
+
+
+
+//!
+//! \brief next Возвращает идентификатор следующего устройства для запроса согласования
+//! \return     Идентификатор устройства или -1, если согласование завершено
+//!
+int CsCapabilities::next() const
+  {
+  for( int id = 0; id < CS_DEVICE_COUNT; id++ )
+    if( mStage[id] < StageDone )
+      return id;
+  return -1;
+  }
@@ -0,0 +1,88 @@
+#include "CsCaptureIndex.hpp"
+
+#include <thread>
+
+//Максимальная длина части записи, разбираемой одним выделителем (индексы в нем типа int)
+#define CS_CAPTURE_CHUNK  (1 << 30)
+
+//Перекрытие частей: запрос с заголовком в конце части дочитывается из следующей
+#define CS_CAPTURE_TAIL   (CS_CMD_FLASH_LENGTH + 1)
+
+//Результат разбора одной части записи
+struct CsCaptureChunk {
+    int64_t              mBegin;                                    //!< Смещение начала части
+    int64_t              mEnd;                                      //!< Смещение конца части
+    std::vector<int64_t> mPostings[CS_DEVICE_COUNT][CS_CMD_COUNT];  //!< Смещения запросов части
+    int64_t              mErrors;                                   //!< Количество ошибок КС
+  };
+
+
+
+//!
+//! \brief csIndexChunk Разобрать часть записи
+//! \param data         Запись
+//! \param size         Размер записи
+//! \param chunk        Часть записи и приемник результата
+//! \param tagged       Маска устройств, запросы к которым записаны с меткой
+//!
+static void csIndexChunk( const char *data, int64_t size, CsCaptureChunk &chunk, uint16_t tagged )
+  {
+  int64_t avail = (chunk.mEnd + CS_CAPTURE_TAIL < size ? chunk.mEnd + CS_CAPTURE_TAIL : size) - chunk.mBegin;
+  //Буфер линейный: размер больше разбираемых данных, поэтому переход через границу не возникает
+  CsFrameScanner scan( data + chunk.mBegin, static_cast<int>(avail) + 1, 0, static_cast<int>(avail), tagged );
+  //Запросы и ошибки КС с заголовком в перекрытии принадлежат следующей части
+  scan.setLimit( static_cast<int>(chunk.mEnd - chunk.mBegin) );
+  CsFrame frame;
+  while( scan.next( frame ) )
+    chunk.mPostings[frame.id()][frame.cmd()].push_back( chunk.mBegin + frame.start() );
+  chunk.mErrors = scan.errors();
+  }
+
+
+
+
+//!
+//! \brief build   Построить индекс записи обмена
+//! \param data    Записанный поток байтов
+//! \param size    Размер записи
+//! \param threads Количество потоков разбора
+//! \param tagged  Маска устройств, запросы к которым записаны с меткой
+//!
+void CsCaptureIndex::build(const char *data, int64_t size, int threads, uint16_t tagged)
+  {
+  if( threads < 1 ) threads = 1;
+  int64_t chunkSize = (size + threads - 1) / threads;
+  if( chunkSize > CS_CAPTURE_CHUNK ) chunkSize = CS_CAPTURE_CHUNK;
+  if( chunkSize < 1 ) chunkSize = 1;
+  int count = static_cast<int>( (size + chunkSize - 1) / chunkSize );
+
+  std::vector<CsCaptureChunk> chunks( count );
+  for( int i = 0; i < count; i++ ) {
+    chunks[i].mBegin = i * chunkSize;
+    chunks[i].mEnd   = chunks[i].mBegin + chunkSize < size ? chunks[i].mBegin + chunkSize : size;
+    }
+
+  //Разбираем части группами по threads
+  for( int first = 0; first < count; first += threads ) {
+    std::vector<std::thread> workers;
+    for( int i = first + 1; i < count && i < first + threads; i++ )
+      workers.emplace_back( csIndexChunk, data, size, std::ref(chunks[i]), tagged );
+    csIndexChunk( data, size, chunks[first], tagged );
+    for( auto &worker : workers )
+      worker.join();
+    }
+
+  //Объединяем списки частей по порядку, смещения остаются упорядоченными
+  mFrames = 0;
+  mErrors = 0;
+  for( int id = 0; id < CS_DEVICE_COUNT; id++ )
+    for( int cmd = 0; cmd < CS_CMD_COUNT; cmd++ ) {
+      std::vector<int64_t> &list = mPostings[id][cmd];
+      list.clear();
+      for( auto &chunk : chunks )
+        list.insert( list.end(), chunk.mPostings[id][cmd].begin(), chunk.mPostings[id][cmd].end() );
+      mFrames += list.size();
+      }
+  for( auto &chunk : chunks )
+    mErrors += chunk.mErrors;
+  }
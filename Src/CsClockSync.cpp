@@ -0,0 +1,130 @@
+#include "CsClockSync.hpp"
+
+//Коэффициенты альфа-бета фильтра смещения и дрейфа
+static const double csClockAlpha = 0.25;
+static const double csClockBeta  = 0.02;
+
+//Отсчет отбрасывается, если время обмена больше минимального в csClockRttFactor раз плюс csClockRttSlack мкс
+static const int64_t csClockRttFactor = 2;
+static const int64_t csClockRttSlack  = 100;
+
+
+CsClockSync::CsClockSync(int id, int index, uint32_t tickHz, int64_t period) :
+  mId(id),
+  mIndex(index),
+  mTickUs(1000000.0 / (tickHz ? tickHz : 1)),
+  mPeriod(period),
+  mSendTime(0),
+  mNextTime(0),
+  mPending(false),
+  mHaveTicks(false),
+  mLastTicks(0),
+  mWraps(0),
+  mMinRtt(-1),
+  mRefTime(0),
+  mOffset(0),
+  mDrift(0),
+  mSamples(0),
+  mRejected(0)
+  {
+
+  }
+
+
+
+
+//!
+//! \brief answer Обработать ответ на запрос синхронизации
+//! \param ticks  Время устройства из ответа (значение параметра)
+//! \param now    Время хоста при приеме ответа, мкс
+//! \return       true, если отсчет принят фильтром
+//!
+bool CsClockSync::answer(uint32_t ticks, int64_t now)
+  {
+  if( !mPending ) return false;
+  mPending  = false;
+  mNextTime = now + mPeriod;
+
+  //Учитываем переполнение счетчика устройства
+  int64_t full = unwrap( ticks, mWraps );
+  mWraps     = full >> 32;
+  mLastTicks = ticks;
+  mHaveTicks = true;
+
+  //Время обмена. Отсчеты с большим временем обмена имеют большую погрешность
+  int64_t rtt = now - mSendTime;
+  if( mMinRtt < 0 || rtt < mMinRtt )
+    mMinRtt = rtt;
+  if( mSamples && rtt > mMinRtt * csClockRttFactor + csClockRttSlack ) {
+    mRejected++;
+    return false;
+    }
+
+  //Время устройства соответствует середине интервала обмена
+  int64_t mid    = mSendTime + rtt / 2;
+  double  sample = full * mTickUs - mid;
+
+  if( mSamples == 0 ) {
+    mOffset = sample;
+    mDrift  = 0;
+    }
+  else {
+    //Прогноз по модели "смещение + постоянный дрейф" и коррекция по невязке
+    double dt       = static_cast<double>(mid - mRefTime);
+    double predict  = mOffset + mDrift * dt;
+    double residual = sample - predict;
+    mOffset = predict + csClockAlpha * residual;
+    if( dt > 0 )
+      mDrift += csClockBeta * residual / dt;
+    }
+  mRefTime = mid;
+  mSamples++;
+  return true;
+  }
+
+
+
+
+//!
+//! \brief deviceTime Преобразовать 32-битный счетчик устройства в 64-битное время устройства с учетом переполнений
+//! \param ticks      Значение счетчика устройства
+//! \return           Время устройства, мкс
+//!
+int64_t CsClockSync::deviceTime(uint32_t ticks) const
+  {
+  return static_cast<int64_t>( unwrap( ticks, mWraps ) * mTickUs );
+  }
+
+
+
+
+//!
+//! \brief hostTime   Перевести время устройства во время хоста
+//! \param deviceTime Время устройства, мкс
+//! \return           Время хоста, мкс
+//!
+int64_t CsClockSync::hostTime(int64_t deviceTime) const
+  {
+  //deviceTime = host + mOffset + mDrift * (host - mRefTime), решаем относительно host
+  double x = (deviceTime - mRefTime - mOffset) / (1.0 + mDrift);
+  return mRefTime + static_cast<int64_t>(x);
+  }
+
+
+
+
+//!
+//! \brief unwrap Восстановить полное значение счетчика устройства по 32-битному значению
+//! \param ticks  32-битное значение счетчика
+//! \param wraps  Количество переполнений на момент последнего принятого значения
+//! \return       Полное значение счетчика
+//!
+int64_t CsClockSync::unwrap(uint32_t ticks, int64_t wraps) const
+  {
+  if( mHaveTicks ) {
+    //Значение ближе к предыдущему через границу переполнения
+    if( ticks < mLastTicks && mLastTicks - ticks > 0x80000000u ) wraps++;
+    else if( ticks > mLastTicks && ticks - mLastTicks > 0x80000000u ) wraps--;
+    }
+  return wraps * 0x100000000ll + ticks;
+  }
@@ -0,0 +1,83 @@
+#include "CsCobs.hpp"
+
+
+//!
+//! \brief csCobsEncode Кодирование блока данных COBS
+//! \param src          Исходные данные
+//! \param size         Длина исходных данных
+//! \param dst          Приемник, не менее CS_COBS_MAX_LENGTH(size) байтов
+//! \return             Длина кодированных данных, включая разделитель 0
+//!
+int csCobsEncode(const char *src, int size, char *dst)
+  {
+  const char *end = src + size;
+  char       *out = dst;
+  while( true ) {
+    int limit = end - src < 254 ? static_cast<int>(end - src) : 254;
+    //Ищем ближайший нулевой байт в пределах блока
+    const char *zero = static_cast<const char*>( memchr( src, 0, limit ) );
+    int len = zero != nullptr ? static_cast<int>(zero - src) : limit;
+    *out++ = len + 1;
+    memcpy( out, src, len );
+    out += len;
+    src += len;
+    if( zero != nullptr ) {
+      //Нулевой байт заменен кодом блока
+      src++;
+      continue;
+      }
+    //Последний блок либо полный блок в конце данных
+    if( len < 254 || src == end )
+      break;
+    }
+  *out++ = 0;
+  return out - dst;
+  }
+
+
+
+
+//!
+//! \brief csCobsDecode Декодирование блока данных COBS
+//! \param src          Кодированные данные без разделителя
+//! \param size         Длина кодированных данных
+//! \param dst          Приемник
+//! \param dstSize      Размер приемника
+//! \return             Длина декодированных данных или -1 при ошибке кадра
+//!
+int csCobsDecode(const char *src, int size, char *dst, int dstSize)
+  {
+  const char *end = src + size;
+  char       *out = dst;
+  char       *outEnd = dst + dstSize;
+  while( src < end ) {
+    int code = *src++ & 0xff;
+    int len  = code - 1;
+    if( code == 0 || len > end - src || len > outEnd - out )
+      return -1;
+    memcpy( out, src, len );
+    out += len;
+    src += len;
+    //Код блока меньше 0xff означает нулевой байт после блока, кроме последнего блока
+    if( code < 0xff && src < end ) {
+      if( out == outEnd ) return -1;
+      *out++ = 0;
+      }
+    }
+  return out - dst;
+  }
+
+
+
+
+CsCobsIn::CsCobsIn(const char *frame, int size, bool query) :
+  mLength(-1),
+  mPtr(query ? 1 : 0)
+  {
+  int len = csCobsDecode( frame, size, mBuffer, CS_COBS_IN_SIZE );
+  //Сообщение должно содержать КС, а запрос - еще и заголовок
+  if( len < mPtr + 1 ) return;
+  len--;
+  if( csMessageCrc( mBuffer, len ) == (mBuffer[len] & 0xff) )
+    mLength = len;
+  }
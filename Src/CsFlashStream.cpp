@@ -0,0 +1,210 @@
+#include "CsFlashStream.hpp"
+
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//!
+//! \brief csFlashWord Возвращает слово образа, неполное последнее слово дополняется 0xff
+//! \param image       Образ прошивки
+//! \param imageSize   Размер образа в байтах
+//! \param i           Номер слова
+//! \return            Слово образа
+//!
+static uint32_t csFlashWord( const char *image, int64_t imageSize, int64_t i )
+  {
+  uint32_t word = 0;
+  for( int k = 0; k < 4; k++ ) {
+    int64_t pos = i * 4 + k;
+    uint32_t byte = pos < imageSize ? static_cast<uint8_t>(image[pos]) : 0xff;
+    word |= byte << (k * 8);
+    }
+  return word;
+  }
+
+
+
+
+//!
+//! \brief csFlashEncodeRange Закодировать часть образа
+//! \param image              Образ прошивки
+//! \param imageSize          Размер образа в байтах
+//! \param base               Адрес первого слова образа
+//! \param id                 Идентификатор прошиваемого устройства
+//! \param dst                Приемник первого сообщения части
+//! \param first              Номер первого слова части
+//! \param last               Номер слова за последним словом части
+//!
+static void csFlashEncodeRange( const char *image, int64_t imageSize, uint32_t base, int id, char *dst, int64_t first, int64_t last )
+  {
+  CsQueryOut<CS_CMD_MSG_FLASH> msg;
+  for( int64_t i = first; i < last; i++, dst += CS_CMD_FLASH_LENGTH ) {
+    msg.makeQueryFlash( id, static_cast<int>(base + 4 * i), static_cast<int>(csFlashWord( image, imageSize, i )) );
+    memcpy( dst, msg.buffer(), CS_CMD_FLASH_LENGTH );
+    }
+  }
+
+
+
+
+//!
+//! \brief csFlashStreamSize Возвращает размер потока прошивки
+//! \param imageSize         Размер образа в байтах
+//! \return                  Размер потока в байтах
+//!
+int64_t csFlashStreamSize(int64_t imageSize)
+  {
+  int64_t frames = (imageSize + 3) / 4;
+  return static_cast<int64_t>(sizeof(CsFlashHeader)) + frames * (4 + CS_CMD_FLASH_LENGTH);
+  }
+
+
+
+
+//!
+//! \brief csFlashEncode Закодировать образ прошивки в поток готовых сообщений
+//! \param image         Образ прошивки
+//! \param imageSize     Размер образа в байтах, неполное последнее слово дополняется 0xff
+//! \param base          Адрес первого слова образа
+//! \param id            Идентификатор прошиваемого устройства
+//! \param dst           Приемник потока размером csFlashStreamSize( imageSize )
+//! \param threads       Количество потоков кодирования
+//!
+void csFlashEncode(const char *image, int64_t imageSize, uint32_t base, int id, char *dst, int threads)
+  {
+  int64_t frames = (imageSize + 3) / 4;
+
+  CsFlashHeader header;
+  header.mMagic       = CS_FLASH_STREAM_MAGIC;
+  header.mVersion     = CS_FLASH_STREAM_VERSION;
+  header.mId          = id & 0xf;
+  header.mFrameLength = CS_CMD_FLASH_LENGTH;
+  header.mFrames      = static_cast<uint32_t>(frames);
+  header.mBase        = base;
+  header.mIndex       = sizeof(CsFlashHeader);
+  header.mData        = static_cast<uint32_t>(header.mIndex + frames * 4);
+  memcpy( dst, &header, sizeof(header) );
+
+  //Индекс
+  for( int64_t i = 0; i < frames; i++ ) {
+    uint32_t offset = static_cast<uint32_t>(header.mData + i * CS_CMD_FLASH_LENGTH);
+    memcpy( dst + header.mIndex + i * 4, &offset, 4 );
+    }
+
+  //Сообщения кодируются независимо, поэтому образ делится на равные части по потокам
+  if( threads < 1 ) threads = 1;
+  int64_t part = (frames + threads - 1) / threads;
+  char *data = dst + header.mData;
+  std::vector<std::thread> workers;
+  for( int64_t first = part; first < frames; first += part ) {
+    int64_t last = first + part < frames ? first + part : frames;
+    workers.emplace_back( csFlashEncodeRange, image, imageSize, base, id, data + first * CS_CMD_FLASH_LENGTH, first, last );
+    }
+  csFlashEncodeRange( image, imageSize, base, id, data, 0, part < frames ? part : frames );
+  for( auto &worker : workers )
+    worker.join();
+  }
+
+
+
+
+//!
+//! \brief csFlashEncodeFile Закодировать образ прошивки в файл потока
+//! \param path              Путь к создаваемому файлу
+//! \param image             Образ прошивки
+//! \param imageSize         Размер образа в байтах
+//! \param base              Адрес первого слова образа
+//! \param id                Идентификатор прошиваемого устройства
+//! \param threads           Количество потоков кодирования
+//! \return                  true при успешной записи
+//!
+bool csFlashEncodeFile(const char *path, const char *image, int64_t imageSize, uint32_t base, int id, int threads)
+  {
+  std::vector<char> stream( csFlashStreamSize( imageSize ) );
+  csFlashEncode( image, imageSize, base, id, stream.data(), threads );
+
+  FILE *f = fopen( path, "wb" );
+  if( f == nullptr ) return false;
+  bool ok = fwrite( stream.data(), 1, stream.size(), f ) == stream.size();
+  return fclose( f ) == 0 && ok;
+  }
+
+
+
+
+//!
+//! \brief open Отобразить файл потока прошивки в память и проверить заголовок и индекс
+//! \param path Путь к файлу
+//! \return     true при успешном открытии
+//!
+bool CsFlashStream::open(const char *path)
+  {
+  close();
+#ifdef __linux__
+  int fd = ::open( path, O_RDONLY );
+  if( fd < 0 ) return false;
+  struct stat st;
+  if( fstat( fd, &st ) != 0 || st.st_size < static_cast<off_t>(sizeof(CsFlashHeader)) ) {
+    ::close( fd );
+    return false;
+    }
+  void *map = mmap( nullptr, st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0 );
+  ::close( fd );
+  if( map == MAP_FAILED ) return false;
+  mMap  = static_cast<const char*>(map);
+  mSize = st.st_size;
+
+  //Проверяем, что заголовок, индекс и сообщения умещаются в файле, а индекс выровнен на 4 байта
+  const CsFlashHeader *header = reinterpret_cast<const CsFlashHeader*>(mMap);
+  if( header->mMagic != CS_FLASH_STREAM_MAGIC || header->mVersion != CS_FLASH_STREAM_VERSION ||
+      header->mFrameLength != CS_CMD_FLASH_LENGTH || header->mFrames > INT32_MAX ||
+      header->mIndex < sizeof(CsFlashHeader) || (header->mIndex & 3) != 0 ||
+      header->mIndex + static_cast<int64_t>(header->mFrames) * 4 > mSize ||
+      header->mData + static_cast<int64_t>(header->mFrames) * CS_CMD_FLASH_LENGTH > mSize ) {
+    close();
+    return false;
+    }
+
+  //Проверяем индекс: с каждого сообщения до конца потока сообщения должны умещаться в файле,
+  //тогда frame(i) можно передавать в порт одной записью без дополнительных проверок
+  const uint32_t *index = reinterpret_cast<const uint32_t*>(mMap + header->mIndex);
+  for( uint32_t i = 0; i < header->mFrames; i++ )
+    if( index[i] < header->mData ||
+        index[i] + static_cast<int64_t>(header->mFrames - i) * CS_CMD_FLASH_LENGTH > mSize ) {
+      close();
+      return false;
+      }
+  mHeader = header;
+  mIndex  = index;
+  return true;
+#else
+  (void)path;
+  return false;
+#endif
+  }
+
+
+
+
+//!
+//! \brief close Закрыть файл потока прошивки
+//!
+void CsFlashStream::close()
+  {
+#ifdef __linux__
+  if( mMap != nullptr )
+    munmap( const_cast<char*>(mMap), mSize );
+#endif
+  mMap    = nullptr;
+  mSize   = 0;
+  mHeader = nullptr;
+  mIndex  = nullptr;
+  }
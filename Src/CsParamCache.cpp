@@ -0,0 +1,168 @@
+#include "CsParamCache.hpp"
+
+#include <string.h>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+//!
+//! \brief open       Открыть или создать файл кэша
+//! \param path       Путь к файлу или nullptr для кэша только в памяти
+//! \param buses      Количество шин
+//! \param generation Поколение конфигурации. Записи другого поколения недействительны
+//! \return           true при успешном открытии
+//!
+bool CsParamCache::open(const char *path, int buses, uint32_t generation)
+  {
+  close();
+  if( buses < 1 ) return false;
+  uint32_t size = sizeof(CsParamFile) + sizeof(CsParamSlot) * CS_DEVICE_COUNT * buses;
+
+#ifdef __linux__
+  if( path != nullptr ) {
+    int fd = ::open( path, O_RDWR | O_CREAT, 0644 );
+    if( fd < 0 ) return false;
+    struct stat st;
+    if( fstat( fd, &st ) != 0 || (st.st_size != static_cast<off_t>(size) && ftruncate( fd, size ) != 0) ) {
+      ::close( fd );
+      return false;
+      }
+    void *map = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    ::close( fd );
+    if( map == MAP_FAILED ) return false;
+    mMap    = static_cast<char*>(map);
+    mMapped = true;
+    }
+#endif
+  if( mMap == nullptr ) {
+    mMap = new char[size];
+    memset( mMap, 0, size );
+    }
+  mSize       = size;
+  mBuses      = buses;
+  mGeneration = generation;
+  mSlots      = reinterpret_cast<CsParamSlot*>( mMap + sizeof(CsParamFile) );
+
+  //Файл другого формата или для другого количества шин очищается целиком
+  CsParamFile *file = reinterpret_cast<CsParamFile*>(mMap);
+  if( file->mMagic != CS_PARAM_CACHE_MAGIC || file->mVersion != CS_PARAM_CACHE_VERSION ||
+      file->mBuses != static_cast<uint32_t>(buses) || file->mSize != size ) {
+    memset( mMap, 0, size );
+    file->mMagic   = CS_PARAM_CACHE_MAGIC;
+    file->mVersion = CS_PARAM_CACHE_VERSION;
+    file->mBuses   = buses;
+    file->mSize    = size;
+    }
+  return true;
+  }
+
+
+
+
+//!
+//! \brief close Закрыть файл кэша
+//!
+void CsParamCache::close()
+  {
+  if( mMap == nullptr ) return;
+#ifdef __linux__
+  if( mMapped )
+    munmap( mMap, mSize );
+  else
+#endif
+    delete [] mMap;
+  mMap    = nullptr;
+  mSlots  = nullptr;
+  mSize   = 0;
+  mMapped = false;
+  mBuses  = 0;
+  }
+
+
+
+
+//!
+//! \brief sync Сбросить изменения кэша на диск
+//!
+void CsParamCache::sync()
+  {
+#ifdef __linux__
+  if( mMapped )
+    msync( mMap, mSize, MS_SYNC );
+#endif
+  }
+
+
+
+
+//!
+//! \brief validate  Проверить запись устройства по результатам чтения сигнатуры и версии.
+//! Если ключ не совпал или заполнение записи не было завершено, запись очищается, получает
+//! новый ключ и принимает значения через set() до вызова commit()
+//! \param bus       Номер шины
+//! \param id        Идентификатор устройства
+//! \param signature Прочитанная сигнатура устройства (CS_CB_SIGNATURE)
+//! \param version   Прочитанная версия программы (CS_CB_VERSION)
+//! \return          true, если сохраненным значениям можно доверять
+//!
+bool CsParamCache::validate(int bus, int id, uint32_t signature, uint32_t version)
+  {
+  CsParamSlot *slot = const_cast<CsParamSlot*>( find( bus, id, 0 ) );
+  if( slot == nullptr ) return false;
+  if( slot->mValid == CS_PARAM_SLOT_VALID && slot->mSignature == signature && slot->mVersion == version && slot->mGeneration == mGeneration )
+    return true;
+
+  //Устройство заменено или перепрошито - значения нужно прочитать заново.
+  //Запись становится действительной только в commit(), после чтения всех значений
+  slot->mValid      = CS_PARAM_SLOT_FILLING;
+  memset( slot->mPresent, 0, sizeof(slot->mPresent) );
+  slot->mSignature  = signature;
+  slot->mVersion    = version;
+  slot->mGeneration = mGeneration;
+  return false;
+  }
+
+
+
+
+//!
+//! \brief commit Завершить заполнение записи устройства после чтения всех параметров.
+//! Только после этого записи можно доверять при следующих запусках
+//! \param bus    Номер шины
+//! \param id     Идентификатор устройства
+//!
+void CsParamCache::commit(int bus, int id)
+  {
+  CsParamSlot *slot = const_cast<CsParamSlot*>( find( bus, id, 0 ) );
+  if( slot == nullptr || slot->mValid != CS_PARAM_SLOT_FILLING ) return;
+#ifdef __linux__
+  //Значения попадают на диск раньше признака действительности
+  if( mMapped ) {
+    uintptr_t page  = static_cast<uintptr_t>( sysconf( _SC_PAGESIZE ) );
+    uintptr_t start = reinterpret_cast<uintptr_t>(slot) & ~(page - 1);
+    msync( reinterpret_cast<void*>(start), reinterpret_cast<uintptr_t>(slot + 1) - start, MS_SYNC );
+    }
+#endif
+  slot->mValid = CS_PARAM_SLOT_VALID;
+  }
+
+
+
+
+//!
+//! \brief invalidate Очистить запись устройства
+//! \param bus        Номер шины
+//! \param id         Идентификатор устройства
+//!
+void CsParamCache::invalidate(int bus, int id)
+  {
+  CsParamSlot *slot = const_cast<CsParamSlot*>( find( bus, id, 0 ) );
+  if( slot == nullptr ) return;
+  slot->mValid = CS_PARAM_SLOT_EMPTY;
+  memset( slot->mPresent, 0, sizeof(slot->mPresent) );
+  }
@@ -0,0 +1,272 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "CsPlacement.hpp"
+
+#ifdef __linux__
+
+#include <dirent.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+//!
+//! \brief csReadInt Прочитать целое число из файла sysfs
+//! \param path      Путь к файлу
+//! \param val       Приемник значения
+//! \return          true при успешном чтении
+//!
+static bool csReadInt( const char *path, int &val )
+  {
+  FILE *f = fopen( path, "r" );
+  if( f == nullptr ) return false;
+  bool ok = fscanf( f, "%d", &val ) == 1;
+  fclose( f );
+  return ok;
+  }
+
+
+
+
+//!
+//! \brief csReadCpuList Прочитать список процессоров в формате 0-7,16-23
+//! \param path          Путь к файлу sysfs или procfs
+//! \param set           Приемник набора процессоров
+//! \return              Количество процессоров в наборе
+//!
+static int csReadCpuList( const char *path, cpu_set_t &set )
+  {
+  CPU_ZERO( &set );
+  FILE *f = fopen( path, "r" );
+  if( f == nullptr ) return 0;
+
+  int count = 0;
+  int first, last;
+  while( fscanf( f, "%d", &first ) == 1 ) {
+    last = first;
+    int ch = fgetc( f );
+    if( ch == '-' ) {
+      if( fscanf( f, "%d", &last ) != 1 ) break;
+      ch = fgetc( f );
+      }
+    for( int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++, count++ )
+      CPU_SET( cpu, &set );
+    if( ch != ',' ) break;
+    }
+  fclose( f );
+  return count;
+  }
+
+
+
+
+//!
+//! \brief csNodeCpus Прочитать список процессоров узла NUMA
+//! \param node       Номер узла NUMA
+//! \param set        Приемник набора процессоров
+//! \return           Количество процессоров в наборе
+//!
+static int csNodeCpus( int node, cpu_set_t &set )
+  {
+  char path[64];
+  snprintf( path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node );
+  return csReadCpuList( path, set );
+  }
+
+
+
+
+//!
+//! \brief csCpuNode Определить узел NUMA процессора
+//! \param cpu       Номер процессора
+//! \return          Номер узла NUMA или -1, если не определен
+//!
+static int csCpuNode( int cpu )
+  {
+  char path[64];
+  snprintf( path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu );
+  DIR *dir = opendir( path );
+  if( dir == nullptr ) return -1;
+  //Каталог процессора содержит ссылку nodeN на свой узел
+  int node = -1;
+  struct dirent *entry;
+  while( node < 0 && (entry = readdir( dir )) != nullptr )
+    if( strncmp( entry->d_name, "node", 4 ) == 0 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9' )
+      node = atoi( entry->d_name + 4 );
+  closedir( dir );
+  return node;
+  }
+
+
+
+
+//!
+//! \brief csTtyIrq Определить прерывание адаптера последовательного порта
+//! \param tty      Имя порта без /dev/, например ttyUSB0
+//! \return         Номер прерывания или -1, если не определено
+//!
+int csTtyIrq(const char *tty)
+  {
+  char link[PATH_MAX];
+  char path[PATH_MAX];
+  snprintf( link, sizeof(link), "/sys/class/tty/%s/device", tty );
+  if( realpath( link, path ) == nullptr ) return -1;
+
+  //Поднимаемся по дереву устройств до ближайшего, имеющего прерывания
+  while( strlen( path ) > 4 ) {
+    char file[PATH_MAX + 16];
+    //Для MSI берем первый вектор, линия irq при этом может быть нулевой
+    snprintf( file, sizeof(file), "%s/msi_irqs", path );
+    DIR *dir = opendir( file );
+    if( dir != nullptr ) {
+      int irq = -1;
+      struct dirent *entry;
+      while( irq < 0 && (entry = readdir( dir )) != nullptr )
+        if( entry->d_name[0] >= '0' && entry->d_name[0] <= '9' )
+          irq = atoi( entry->d_name );
+      closedir( dir );
+      if( irq > 0 ) return irq;
+      }
+    snprintf( file, sizeof(file), "%s/irq", path );
+    int irq;
+    if( csReadInt( file, irq ) && irq > 0 )
+      return irq;
+    char *slash = strrchr( path, '/' );
+    if( slash == nullptr ) break;
+    *slash = 0;
+    }
+  return -1;
+  }
+
+
+
+
+//!
+//! \brief csIrqNode Определить узел NUMA, на котором обрабатывается прерывание
+//! \param irq       Номер прерывания
+//! \return          Номер узла NUMA или -1, если не определен
+//!
+int csIrqNode(int irq)
+  {
+  if( irq < 0 ) return -1;
+  char path[64];
+  int  node;
+  snprintf( path, sizeof(path), "/proc/irq/%d/node", irq );
+  if( csReadInt( path, node ) && node >= 0 )
+    return node;
+
+  //Узел не задан - определяем по процессорам, обслуживающим прерывание
+  cpu_set_t set;
+  snprintf( path, sizeof(path), "/proc/irq/%d/effective_affinity_list", irq );
+  if( csReadCpuList( path, set ) == 0 ) {
+    snprintf( path, sizeof(path), "/proc/irq/%d/smp_affinity_list", irq );
+    if( csReadCpuList( path, set ) == 0 ) return -1;
+    }
+  for( int cpu = 0; cpu < CPU_SETSIZE; cpu++ )
+    if( CPU_ISSET( cpu, &set ) )
+      return csCpuNode( cpu );
+  return -1;
+  }
+
+
+
+
+//!
+//! \brief csTtyNumaNode Определить узел NUMA, к которому подключен адаптер последовательного порта
+//! \param tty           Имя порта без /dev/, например ttyUSB0
+//! \return              Номер узла NUMA или -1, если не определен
+//!
+int csTtyNumaNode(const char *tty)
+  {
+  char link[PATH_MAX];
+  char path[PATH_MAX];
+  snprintf( link, sizeof(link), "/sys/class/tty/%s/device", tty );
+  if( realpath( link, path ) == nullptr ) return -1;
+
+  //Поднимаемся по дереву устройств до ближайшего, у которого есть numa_node (как правило, PCI)
+  size_t len = strlen( path );
+  while( len > 4 ) {
+    char file[PATH_MAX + 16];
+    snprintf( file, sizeof(file), "%s/numa_node", path );
+    int node;
+    if( csReadInt( file, node ) )
+      return node;
+    char *slash = strrchr( path, '/' );
+    if( slash == nullptr ) break;
+    *slash = 0;
+    len = slash - path;
+    }
+  return -1;
+  }
+
+
+
+
+//!
+//! \brief csNodeCpuCount Возвращает количество процессоров узла NUMA
+//! \param node           Номер узла NUMA
+//! \return               Количество процессоров или 0, если узел не найден
+//!
+int csNodeCpuCount(int node)
+  {
+  cpu_set_t set;
+  return node < 0 ? 0 : csNodeCpus( node, set );
+  }
+
+
+
+
+//!
+//! \brief csBindToNode Привязать текущий поток к процессорам узла NUMA
+//! \param node         Номер узла NUMA
+//! \return             true при успешной привязке
+//!
+bool csBindToNode(int node)
+  {
+  cpu_set_t set;
+  if( node < 0 || csNodeCpus( node, set ) == 0 ) return false;
+  return pthread_setaffinity_np( pthread_self(), sizeof(set), &set ) == 0;
+  }
+
+
+
+
+//!
+//! \brief csPlaceBusThread Привязать текущий поток к узлу NUMA прерывания адаптера шины
+//! \param tty              Имя порта без /dev/, например ttyUSB0
+//! \return                 Размещение потока (прерывание, узел и текущий процессор)
+//!
+CsBusPlacement csPlaceBusThread(const char *tty)
+  {
+  CsBusPlacement placement;
+  placement.mIrq  = csTtyIrq( tty );
+  placement.mNode = csIrqNode( placement.mIrq );
+  //Прерывание не определено - используем узел адаптера
+  if( placement.mNode < 0 )
+    placement.mNode = csTtyNumaNode( tty );
+  //Узел -1 означает, что система не NUMA - привязка не нужна
+  if( placement.mNode >= 0 )
+    csBindToNode( placement.mNode );
+  placement.mCpu = sched_getcpu();
+  return placement;
+  }
+
+#else
+
+int  csTtyIrq( const char * ) { return -1; }
+
+int  csIrqNode( int ) { return -1; }
+
+int  csTtyNumaNode( const char * ) { return -1; }
+
+int  csNodeCpuCount( int ) { return 0; }
+
+bool csBindToNode( int ) { return false; }
+
+CsBusPlacement csPlaceBusThread( const char * ) { return CsBusPlacement(); }
+
+#endif
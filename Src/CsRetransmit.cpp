@@ -0,0 +1,37 @@
+#include "CsRetransmit.hpp"
+
+
+//!
+//! \brief cost Возвращает время, необходимое на повтор запроса
+//! \param cmd  Команда запроса
+//! \param rtt  Оценка времени обмена с устройством или nullptr
+//! \return     Время повтора, мкс
+//!
+int CsRetransmitPolicy::cost(int cmd, const CsRttEstimator *rtt) const
+  {
+  //Повтор занимает шину не дольше времени ожидания ответа
+  if( rtt != nullptr )
+    return rtt->timeout( cmd );
+  return csExchangeTime( cmd, mBaud ) + CS_RTT_TURNAROUND;
+  }
+
+
+
+
+//!
+//! \brief crcError Обработать ответ с ошибкой КС
+//! \param cmd      Команда запроса
+//! \param attempt  Номер попытки, на которую получен ответ (0 - исходный запрос)
+//! \param slack    Оставшийся запас времени текущего цикла, мкс
+//! \param rtt      Оценка времени обмена с устройством или nullptr
+//! \return         true, если запрос нужно немедленно повторить, false - ответ потерян
+//!
+bool CsRetransmitPolicy::crcError(int cmd, int attempt, int slack, const CsRttEstimator *rtt)
+  {
+  if( attempt < mMaxRetries && cost( cmd, rtt ) <= slack ) {
+    mRetries++;
+    return true;
+    }
+  mLost++;
+  return false;
+  }
@@ -0,0 +1,92 @@
+#include "CsRttEstimator.hpp"
+
+
+//!
+//! \brief reset Сбросить оценку
+//! \param baud  Скорость обмена, бод
+//!
+void CsRttEstimator::reset(int baud)
+  {
+  mSrtt8    = 0;
+  mRttvar4  = 0;
+  mBaud     = baud;
+  mMeasured = false;
+  mMisses   = 0;
+  mSkip     = 0;
+  }
+
+
+
+
+//!
+//! \brief sample Учесть измеренное время обмена
+//! \param cmd    Команда запроса
+//! \param rtt    Время от начала передачи запроса до приема ответа, мкс
+//!
+void CsRttEstimator::sample(int cmd, int rtt)
+  {
+  mMisses = 0;
+  mSkip   = 0;
+  //Сглаживается только время реакции устройства, время передачи известно по команде
+  int turnaround = mBaud > 0 ? rtt - csExchangeTime( cmd, mBaud ) : rtt;
+  if( turnaround < 0 ) turnaround = 0;
+  if( !mMeasured ) {
+    //Первое измерение
+    mMeasured = true;
+    mSrtt8    = turnaround << 3;
+    mRttvar4  = turnaround << 1;
+    return;
+    }
+  //Целочисленный вариант алгоритма Джекобсона
+  int delta = turnaround - (mSrtt8 >> 3);
+  mSrtt8 += delta;
+  if( delta < 0 ) delta = -delta;
+  mRttvar4 += delta - (mRttvar4 >> 2);
+  }
+
+
+
+
+//!
+//! \brief miss Учесть отсутствие ответа за время ожидания
+//!
+void CsRttEstimator::miss()
+  {
+  if( mMisses < 0x7fff ) mMisses++;
+  }
+
+
+
+
+//!
+//! \brief timeout Возвращает время ожидания ответа
+//! \param cmd     Команда запроса
+//! \return        Время ожидания от начала передачи запроса, мкс
+//!
+int CsRttEstimator::timeout(int cmd) const
+  {
+  if( mBaud <= 0 )
+    return CS_RTT_MAX;
+  //Отсутствующее устройство или нет измерений - ждем только по модели времени передачи
+  int wait = CS_RTT_TURNAROUND;
+  if( mMeasured && !absent() )
+    wait = (mSrtt8 >> 3) + (mRttvar4 > CS_RTT_GRANULARITY ? mRttvar4 : CS_RTT_GRANULARITY);
+  if( wait > CS_RTT_MAX ) wait = CS_RTT_MAX;
+  return csExchangeTime( cmd, mBaud ) + wait;
+  }
+
+
+
+
+//!
+//! \brief poll Вызывается один раз за цикл перед опросом устройства
+//! \return     true, если устройство нужно опрашивать в этом цикле
+//!
+bool CsRttEstimator::poll()
+  {
+  if( !absent() ) return true;
+  //Отсутствующее устройство опрашиваем раз в CS_RTT_PROBE_PERIOD циклов
+  if( ++mSkip < CS_RTT_PROBE_PERIOD ) return false;
+  mSkip = 0;
+  return true;
+  }
@@ -0,0 +1,120 @@
+#include "CsSignatureSweep.hpp"
+
+#include <string.h>
+
+
+CsSignatureSweep::CsSignatureSweep(uint16_t ids, uint16_t tagged) :
+  mIds(ids & ~(1 << CS_ID_BROADCAST)),
+  mSeen(0),
+  mSent(0),
+  mDone(0),
+  mTagged(tagged),
+  mCurrent(-1),
+  mLength(0),
+  mSkip(0)
+  {
+  memset( mSignature, 0, sizeof(mSignature) );
+  }
+
+
+
+
+//!
+//! \brief makeQueries Сформировать очередной запрос. Пока ожидается ответ на переданный
+//! запрос, новый не формируется
+//! \param dst         Буфер-приемник
+//! \param capacity    Размер буфера
+//! \return            Количество байтов запроса или 0, если передавать нечего
+//!
+int CsSignatureSweep::makeQueries(char *dst, int capacity)
+  {
+  //На полудуплексной шине следующий запрос передается только после ответа или тайм-аута
+  if( mCurrent >= 0 ) return 0;
+  for( int id = 0; id < CS_DEVICE_COUNT; id++ ) {
+    if( !(mIds & ~mSent & (1 << id)) ) continue;
+    CsQueryOut<CS_CMD_MSG_READ> msg;
+    if( csTagLength( mTagged, id ) ) {
+      msg.beginTaggedQuery( CS_CMD_MSG_READ, id, 0 );
+      msg.addInt16( CS_CB_SIGNATURE );
+      msg.end();
+      }
+    else
+      msg.makeQueryRead( id, CS_CB_SIGNATURE );
+    if( msg.length() > capacity ) return 0;
+    memcpy( dst, msg.buffer(), msg.length() );
+    mSent   |= 1 << id;
+    mCurrent = id;
+    return msg.length();
+    }
+  return 0;
+  }
+
+
+
+
+//!
+//! \brief feed Обработать принятые байты
+//! \param data Принятые байты
+//! \param size Количество байтов
+//!
+void CsSignatureSweep::feed(const char *data, int size)
+  {
+  for( int i = 0; i < size; i++ ) {
+    char ch = data[i];
+    if( mSkip ) {
+      mSkip--;
+      continue;
+      }
+    //Заголовок - эхо собственного запроса, пропускаем его целиком
+    if( (ch & 0x80) == 0 ) {
+      mSkip   = csMessageLength( ch ) ? csMessageLength( ch ) + csTagLength( mTagged, csMessageId( ch ) ) - 1 : 0;
+      mLength = 0;
+      continue;
+      }
+    if( mCurrent < 0 ) continue;
+    int tag = csTagLength( mTagged, mCurrent );
+    int len = csAnswerLengths[CS_CMD_MSG_READ] + tag;
+    mAnswer[mLength++] = ch;
+    if( mLength < len ) continue;
+
+    //Ответ с меткой должен относиться к опрашиваемому устройству
+    if( CsMessageIn( mAnswer, 0, sizeof(mAnswer) ).checkCrc( len ) && (!tag || (mAnswer[0] & 0xf) == mCurrent) ) {
+      mSignature[mCurrent] = CsFrame( mAnswer, sizeof(mAnswer), 0, len, tag ).getInt32At( CS_BIT_ANSWER_VALUE );
+      accept( mCurrent );
+      mLength = 0;
+      }
+    else {
+      //Сдвигаемся на байт, чтобы найти начало ответа после искажения
+      memmove( mAnswer, mAnswer + 1, --mLength );
+      }
+    }
+  }
+
+
+
+
+//!
+//! \brief timeout Сообщить об истечении времени ожидания ответа на переданный запрос
+//!
+void CsSignatureSweep::timeout()
+  {
+  //Устройство, не ответившее на переданный запрос, отсутствует
+  mDone |= mSent;
+  mCurrent = -1;
+  mLength  = 0;
+  mSkip    = 0;
+  }
+
+
+
+
+//!
+//! \brief accept Отметить ответившее устройство
+//! \param id     Идентификатор устройства
+//!
+void CsSignatureSweep::accept(int id)
+  {
+  mSeen |= 1 << id;
+  mDone |= 1 << id;
+  if( id == mCurrent ) mCurrent = -1;
+  }
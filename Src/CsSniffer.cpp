@@ -0,0 +1,222 @@
+#include "CsSniffer.hpp"
+
+
+CsSniffer::CsSniffer(int baud, uint16_t tagged, CsSniffFn handler, void *context) :
+  mHead(0),
+  mAvail(0),
+  mTagged(tagged),
+  mByteTime(baud > 0 ? static_cast<uint32_t>( static_cast<uint64_t>(CS_UART_BITS_PER_BYTE) * 1000000000 / baud ) : 0),
+  mHandler(handler),
+  mContext(context)
+  {
+  reset();
+  }
+
+
+
+
+//!
+//! \brief feed Обработать принятый блок данных
+//! \param data Принятые байты
+//! \param size Количество байтов
+//! \param time Время приема последнего байта блока, мкс
+//!
+void CsSniffer::feed(const char *data, int size, uint32_t time)
+  {
+  while( size > 0 ) {
+    int part = CS_SNIFF_RING - mAvail;
+    if( part > size ) part = size;
+    int tail = (mHead + mAvail) & (CS_SNIFF_RING - 1);
+    for( int i = 0; i < part; i++ ) {
+      mRing[tail]  = data[i];
+      //Байты блока передавались друг за другом, последний принят в момент time
+      mTimes[tail] = time - static_cast<uint32_t>( static_cast<uint64_t>(size - 1 - i) * mByteTime / 1000 );
+      tail = (tail + 1) & (CS_SNIFF_RING - 1);
+      }
+    mAvail += part;
+    data   += part;
+    size   -= part;
+    while( step() );
+    }
+  }
+
+
+
+
+//!
+//! \brief reset Сбросить ожидающие запросы и статистику
+//!
+void CsSniffer::reset()
+  {
+  for( int id = 0; id < CS_DEVICE_COUNT; id++ ) {
+    for( int seq = 0; seq < CS_TAG_SEQ_COUNT; seq++ )
+      mPending[id][seq].mLength = 0;
+    mStat[id] = CsSniffStat();
+    }
+  mWaitId = -1;
+  mFrameErrors = 0;
+  }
+
+
+
+
+//!
+//! \brief step Разобрать очередной запрос или ответ в начале неразобранных данных
+//! \return     true, если данные разобраны, false - если нужно дождаться следующих байтов
+//!
+bool CsSniffer::step()
+  {
+  if( mAvail == 0 ) return false;
+  char ch = at(0);
+  if( (ch & 0x80) == 0 )
+    return query();
+
+  //Байт данных может начинать только ответ на ожидающий запрос. Ответ устройства
+  //без меток следует сразу за запросом, иначе ответ сопоставляется по метке
+  int id = -1;
+  Pending *pending = nullptr;
+  if( mWaitId >= 0 ) {
+    id = mWaitId;
+    pending = &mPending[id][0];
+    }
+  else if( tag( ch & 0xf ) ) {
+    id = ch & 0xf;
+    pending = &mPending[id][csTagSeq(ch)];
+    }
+  if( pending == nullptr || pending->mLength == 0 ) {
+    skip(1);
+    return true;
+    }
+  return answer( *pending, id );
+  }
+
+
+
+
+//!
+//! \brief query Разобрать запрос в начале неразобранных данных
+//! \return      true, если данные разобраны, false - если нужно дождаться следующих байтов
+//!
+bool CsSniffer::query()
+  {
+  int len = csMessageLength( at(0) );
+  if( len == 0 ) {
+    skip(1);
+    return true;
+    }
+  int tagged = tag( csMessageId( at(0) ) );
+  len += tagged;
+
+  //Выделитель ограничивается одним запросом, чтобы не пропустить следующие за ним ответы
+  CsFrameScanner scan( mRing, CS_SNIFF_RING, mHead, mAvail < len ? mAvail : len, mTagged );
+  CsFrame frame;
+  if( !scan.next( frame ) ) {
+    int used = (scan.head() - mHead) & (CS_SNIFF_RING - 1);
+    if( used == 0 ) return false;
+    mFrameErrors++;
+    skip(used);
+    return true;
+    }
+
+  int id  = frame.id();
+  int cmd = frame.cmd();
+  Pending &pending = mPending[id][tagged ? csTagSeq( frame.at(1) ) : 0];
+
+  //Новый запрос означает, что запрос к устройству без меток остался без ответа
+  if( mWaitId >= 0 ) {
+    Pending &last = mPending[mWaitId][0];
+    mStat[mWaitId].mMissing++;
+    report( last, CsFrame(), -1 );
+    last.mLength = 0;
+    mWaitId = -1;
+    }
+  //а запрос с той же меткой - что без ответа остался предыдущий запрос с этой меткой
+  if( pending.mLength ) {
+    mStat[id].mMissing++;
+    report( pending, CsFrame(), -1 );
+    pending.mLength = 0;
+    }
+
+  mStat[id].mQueries++;
+  Pending current;
+  for( int i = 0; i < len; i++ )
+    current.mBytes[i] = frame.at(i);
+  current.mLength = len;
+  current.mTime   = mTimes[(mHead + len - 1) & (CS_SNIFF_RING - 1)];
+  skip(len);
+
+  if( csAnswerLengths[cmd] == 0 || (id == CS_ID_BROADCAST && cmd == CS_CMD_MSG_WRITE) )
+    //Ответ не предусмотрен
+    report( current, CsFrame(), -1 );
+  else {
+    pending = current;
+    if( !tagged ) mWaitId = id;
+    }
+  return true;
+  }
+
+
+
+
+//!
+//! \brief answer  Разобрать ответ в начале неразобранных данных
+//! \param pending Запрос, на который ожидается ответ
+//! \param id      Идентификатор устройства
+//! \return        true, если данные разобраны, false - если нужно дождаться следующих байтов
+//!
+bool CsSniffer::answer(Pending &pending, int id)
+  {
+  int tagged = tag( id );
+  int len = csAnswerLengths[csMessageCmd(pending.mBytes[0])] + tagged;
+  int avail = mAvail < len ? mAvail : len;
+
+  //Ответ прерван заголовком следующего запроса
+  int i = 1;
+  while( i < avail && (at(i) & 0x80) ) i++;
+  bool broken = i < avail;
+  if( !broken && mAvail < len ) return false;
+
+  //Начало ответа в линии на время передачи байта раньше его приема
+  uint32_t start = mTimes[mHead] - mByteTime / 1000;
+  int32_t latency = static_cast<int32_t>(start - pending.mTime);
+  if( latency < 0 ) latency = 0;
+  if( broken || !CsMessageIn( mRing, mHead, CS_SNIFF_RING ).checkCrc( len ) ) {
+    mStat[id].mCrcErrors++;
+    //Ответ с ошибкой тоже занимал линию
+    report( pending, CsFrame(), latency, broken ? i : len );
+    }
+  else {
+    CsSniffStat &st = mStat[id];
+    st.mAnswers++;
+    st.mLatencySum += latency;
+    if( static_cast<uint32_t>(latency) < st.mLatencyMin ) st.mLatencyMin = latency;
+    if( static_cast<uint32_t>(latency) > st.mLatencyMax ) st.mLatencyMax = latency;
+    report( pending, CsFrame( mRing, CS_SNIFF_RING, mHead, len, tagged ), latency );
+    }
+  pending.mLength = 0;
+  if( !tagged ) mWaitId = -1;
+  skip(i);
+  return true;
+  }
+
+
+
+
+//!
+//! \brief report  Передать пару запрос-ответ функции обработки
+//! \param pending Запрос
+//! \param answer  Ответ или пустой кадр
+//! \param latency Задержка ответа, мкс, или -1
+//! \param errorBytes Количество байтов ответа с ошибкой
+//!
+void CsSniffer::report(Pending &pending, const CsFrame &answer, int32_t latency, int errorBytes)
+  {
+  if( mHandler == nullptr ) return;
+  CsSniffRecord record;
+  record.mQuery   = CsFrame( pending.mBytes, sizeof(pending.mBytes), 0, pending.mLength, 1 + tag( csMessageId( pending.mBytes[0] ) ) );
+  record.mAnswer  = answer;
+  record.mTime    = pending.mTime;
+  record.mLatency = latency;
+  record.mErrorBytes = errorBytes;
+  mHandler( mContext, record );
+  }
@@ -0,0 +1,113 @@
+#include "CsTagTracker.hpp"
+
+
+CsTagTracker::CsTagTracker(int window) :
+  mWindow(window < 1 ? 1 : (window > CS_TAG_SEQ_COUNT ? CS_TAG_SEQ_COUNT : window))
+  {
+  for( int id = 0; id < CS_DEVICE_COUNT; id++ ) {
+    for( int seq = 0; seq < CS_TAG_SEQ_COUNT; seq++ ) {
+      mSlots[id][seq].mTime = 0;
+      mSlots[id][seq].mCmd  = -1;
+      }
+    mNext[id]  = 0;
+    mCount[id] = 0;
+    }
+  }
+
+
+
+
+//!
+//! \brief issue Выделить номер для нового запроса
+//! \param id    Идентификатор устройства
+//! \param cmd   Команда запроса
+//! \param now   Время отправки запроса, мкс
+//! \return      Номер запроса (0-7) или -1, если окно запросов к устройству заполнено.
+//!              Запросу без ответа номер выдается без учета в окне
+//!
+int CsTagTracker::issue(int id, int cmd, int64_t now)
+  {
+  id &= 0xf;
+  if( csAnswerLengths[cmd & 0x7] == 0 ) {
+    //На запрос без ответа номер не занимается: ответ не освободил бы его
+    int seq = mNext[id];
+    mNext[id] = (seq + 1) % CS_TAG_SEQ_COUNT;
+    return seq;
+    }
+  if( mCount[id] >= mWindow ) return -1;
+  //Номера выдаются по кругу, пропуская занятые
+  for( int i = 0; i < CS_TAG_SEQ_COUNT; i++ ) {
+    int seq = (mNext[id] + i) % CS_TAG_SEQ_COUNT;
+    Slot &slot = mSlots[id][seq];
+    if( slot.mCmd < 0 ) {
+      slot.mCmd  = cmd & 0x7;
+      slot.mTime = now;
+      mCount[id]++;
+      mNext[id] = (seq + 1) % CS_TAG_SEQ_COUNT;
+      return seq;
+      }
+    }
+  return -1;
+  }
+
+
+
+
+//!
+//! \brief answerLength Возвращает полную длину ответа по байту метки
+//! \param tag          Байт метки (первый байт ответа)
+//! \return             Длина ответа, включая метку и КС, или 0, если такой запрос не ожидается
+//!
+int CsTagTracker::answerLength(char tag) const
+  {
+  int cmd = mSlots[csMessageId(tag)][csTagSeq(tag)].mCmd;
+  return cmd < 0 ? 0 : csAnswerLengths[cmd] + 1;
+  }
+
+
+
+
+//!
+//! \brief match Сопоставить ответ с запросом и освободить номер
+//! \param tag   Байт метки (первый байт ответа)
+//! \param cmd   Приемник команды запроса
+//! \param time  Приемник времени отправки запроса, мкс
+//! \return      true, если запрос с такой меткой ожидал ответа
+//!
+bool CsTagTracker::match(char tag, int &cmd, int64_t &time)
+  {
+  int id = csMessageId(tag);
+  Slot &slot = mSlots[id][csTagSeq(tag)];
+  if( slot.mCmd < 0 ) return false;
+  cmd  = slot.mCmd;
+  time = slot.mTime;
+  slot.mCmd = -1;
+  mCount[id]--;
+  return true;
+  }
+
+
+
+
+//!
+//! \brief expire  Освободить номера запросов, ответ на которые не получен за время ожидания
+//! \param now     Текущее время, мкс
+//! \param timeout Время ожидания, мкс
+//! \return        Количество освобожденных номеров
+//!
+int CsTagTracker::expire(int64_t now, int64_t timeout)
+  {
+  int count = 0;
+  for( int id = 0; id < CS_DEVICE_COUNT; id++ ) {
+    if( mCount[id] == 0 ) continue;
+    for( int seq = 0; seq < CS_TAG_SEQ_COUNT; seq++ ) {
+      Slot &slot = mSlots[id][seq];
+      if( slot.mCmd >= 0 && now - slot.mTime >= timeout ) {
+        slot.mCmd = -1;
+        mCount[id]--;
+        count++;
+        }
+      }
+    }
+  return count;
+  }
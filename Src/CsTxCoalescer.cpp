@@ -0,0 +1,78 @@
+#include "CsTxCoalescer.hpp"
+
+#include <string.h>
+
+
+CsTxCoalescer::CsTxCoalescer(CsTxWriteFn write, void *context, int packetSize, uint32_t budget) :
+  mLength(0),
+  mPacketSize(packetSize < 1 ? 1 : (packetSize > CS_TX_PACKET_MAX ? CS_TX_PACKET_MAX : packetSize)),
+  mBudget(budget),
+  mFirstTime(0),
+  mWrite(write),
+  mContext(context),
+  mWrites(0),
+  mBytes(0)
+  {
+
+  }
+
+
+
+
+//!
+//! \brief append Добавить закодированное сообщение. Полностью заполненные пакеты сразу записываются в порт
+//! \param frame  Закодированное сообщение
+//! \param size   Длина сообщения
+//! \param now    Текущее время, мкс
+//!
+void CsTxCoalescer::append(const char *frame, int size, uint32_t now)
+  {
+  //Если бюджет задержки уже истек, то сначала отправляем накопленное
+  poll( now );
+
+  while( size > 0 ) {
+    if( mLength == 0 )
+      mFirstTime = now;
+
+    //Дополняем текущий пакет
+    int part = mPacketSize - mLength;
+    if( part > size ) part = size;
+    memcpy( mBuffer + mLength, frame, part );
+    mLength += part;
+    frame   += part;
+    size    -= part;
+
+    //Пакет заполнен полностью - отправляем
+    if( mLength == mPacketSize )
+      flush();
+    }
+  }
+
+
+
+
+//!
+//! \brief poll Записать накопленные данные, если истек бюджет задержки
+//! \param now  Текущее время, мкс
+//!
+void CsTxCoalescer::poll(uint32_t now)
+  {
+  //Разность беззнаковая, поэтому переполнение счетчика времени не мешает
+  if( mLength && (now - mFirstTime) >= mBudget )
+    flush();
+  }
+
+
+
+
+//!
+//! \brief flush Записать все накопленные данные
+//!
+void CsTxCoalescer::flush()
+  {
+  if( mLength == 0 ) return;
+  mWrite( mContext, mBuffer, mLength );
+  mWrites++;
+  mBytes += mLength;
+  mLength = 0;
+  }
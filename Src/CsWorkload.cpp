@@ -0,0 +1,223 @@
+#include "CsWorkload.hpp"
+
+#include <stdio.h>
+#include <string.h>
+
+
+//!
+//! \brief csWorkloadFields Добавить в сообщение поля со случайными значениями
+//! \param msg              Кодировщик сообщения
+//! \param cmd              Команда
+//! \param answer           true - поля ответа, false - поля запроса
+//! \param gen              Генератор случайных чисел
+//!
+static void csWorkloadFields( CsMessageOut &msg, int cmd, bool answer, CsWorkload &gen )
+  {
+  int v0 = static_cast<int>( gen.random() );
+  int v1 = static_cast<int>( gen.random() );
+  switch( cmd ) {
+    case CS_CMD_MSG_CONTROL :
+      msg.addInt16( v0 );
+      if( answer ) msg.addInt16( v1 );
+      break;
+
+    case CS_CMD_MSG_CONTROL_NA :
+      if( !answer ) msg.addInt16( v0 );
+      break;
+
+    case CS_CMD_MSG_INFO :
+      if( answer ) {
+        msg.addInt16( v0 );
+        msg.addInt16( v0 >> 16 );
+        msg.addInt16( v1 );
+        }
+      break;
+
+    case CS_CMD_MSG_WRITE :
+      if( !answer ) msg.addInt16( v1 );
+      msg.addInt32( v0 );
+      break;
+
+    case CS_CMD_MSG_READ :
+      if( answer ) msg.addInt32( v0 );
+      else         msg.addInt16( v1 );
+      break;
+
+    case CS_CMD_MSG_FLASH :
+      if( answer ) msg.addInt8( CS_ID_BROADCAST );
+      else         msg.addInt32( v1 );
+      msg.addInt32( v0 );
+      break;
+    }
+  }
+
+
+
+
+CsWorkload::CsWorkload(uint64_t seed, const CsWorkloadMix &mix) :
+  mState(seed ? seed : 1),
+  mMix(mix),
+  mWeightSum(0),
+  mUnitLength(0),
+  mUnitPtr(0),
+  mQueries(0),
+  mAnswers(0),
+  mErrors(0)
+  {
+  for( int cmd = 0; cmd < 8; cmd++ ) {
+    if( csCmdLengths[cmd] == 0 ) mMix.mWeights[cmd] = 0;
+    mWeightSum += mMix.mWeights[cmd];
+    }
+  if( mWeightSum == 0 ) {
+    mMix.mWeights[CS_CMD_MSG_CONTROL] = 1;
+    mWeightSum = 1;
+    }
+  if( mMix.mIds == 0 ) mMix.mIds = 0x7ffe;
+  memset( mSeq, 0, sizeof(mSeq) );
+  mNextError = mMix.mErrorPpm ? random( 2000000 / mMix.mErrorPpm + 1 ) : 0;
+  }
+
+
+
+
+//!
+//! \brief fill Заполнить линейный буфер очередными байтами потока
+//! \param dst  Буфер-приемник
+//! \param size Количество байтов
+//!
+void CsWorkload::fill(char *dst, int64_t size)
+  {
+  while( size > 0 ) {
+    if( mUnitPtr == mUnitLength ) nextUnit();
+    int part = mUnitLength - mUnitPtr;
+    if( part > size ) part = static_cast<int>(size);
+    memcpy( dst, mUnit + mUnitPtr, part );
+    mUnitPtr += part;
+    dst      += part;
+    size     -= part;
+    }
+  }
+
+
+
+
+//!
+//! \brief fillRing Записать очередные байты потока в циклический буфер
+//! \param ring     Циклический буфер
+//! \param ringSize Размер циклического буфера
+//! \param tail     Индекс, по которому записывается первый байт
+//! \param count    Количество байтов
+//! \return         Индекс, по которому будет записан следующий байт
+//!
+int CsWorkload::fillRing(char *ring, int ringSize, int tail, int count)
+  {
+  while( count > 0 ) {
+    int part = ringSize - tail;
+    if( part > count ) part = count;
+    fill( ring + tail, part );
+    tail += part;
+    if( tail == ringSize ) tail = 0;
+    count -= part;
+    }
+  return tail;
+  }
+
+
+
+
+//!
+//! \brief writeFile Записать очередные байты потока в файл записи обмена
+//! \param path      Путь к файлу
+//! \param size      Количество байтов
+//! \return          true при успешной записи
+//!
+bool CsWorkload::writeFile(const char *path, int64_t size)
+  {
+  FILE *f = fopen( path, "wb" );
+  if( f == nullptr ) return false;
+  static const int blockSize = 1 << 20;
+  char *block = new char[blockSize];
+  bool ok = true;
+  while( ok && size > 0 ) {
+    int part = size < blockSize ? static_cast<int>(size) : blockSize;
+    fill( block, part );
+    ok = fwrite( block, 1, part, f ) == static_cast<size_t>(part);
+    size -= part;
+    }
+  delete [] block;
+  return fclose( f ) == 0 && ok;
+  }
+
+
+
+
+//!
+//! \brief nextUnit Сформировать очередной обмен: запрос, эхо, ответ и шум
+//!
+void CsWorkload::nextUnit()
+  {
+  //Команда по заданным частотам
+  uint32_t pick = random( mWeightSum );
+  int cmd = 0;
+  while( pick >= mMix.mWeights[cmd] ) pick -= mMix.mWeights[cmd++];
+
+  //Устройство из маски; прошивка всегда ведется по универсальному идентификатору
+  int id = CS_ID_BROADCAST;
+  if( cmd != CS_CMD_MSG_FLASH ) {
+    //Широковещательной бывает только запись параметра
+    uint16_t mask = mMix.mIds;
+    if( cmd != CS_CMD_MSG_WRITE ) mask &= ~(1 << CS_ID_BROADCAST);
+    if( mask == 0 ) {
+      cmd  = CS_CMD_MSG_WRITE;
+      mask = mMix.mIds;
+      }
+    int count = 0;
+    for( uint16_t ids = mask; ids; ids &= ids - 1 ) count++;
+    int k = random( count );
+    for( id = 0; !(mask & (1 << id)) || k--; id++ );
+    }
+
+  CsMessageOut msg;
+  int seq = mSeq[id]++ & (CS_TAG_SEQ_COUNT - 1);
+  if( mMix.mTagged ) msg.beginTaggedQuery( cmd, id, seq );
+  else               msg.beginQuery( cmd, id );
+  csWorkloadFields( msg, cmd, false, *this );
+  msg.end();
+  memcpy( mUnit, msg.buffer(), msg.length() );
+  mUnitLength = msg.length();
+  mQueries++;
+
+  //Эхо собственной передачи
+  if( random( 100 ) < mMix.mEchoPercent ) {
+    memcpy( mUnit + mUnitLength, msg.buffer(), msg.length() );
+    mUnitLength += msg.length();
+    }
+
+  //Ответ, если он предусмотрен командой
+  bool silent = csAnswerLengths[cmd] == 0 || (id == CS_ID_BROADCAST && cmd == CS_CMD_MSG_WRITE);
+  if( !silent && random( 100 ) < mMix.mAnswerPercent ) {
+    if( mMix.mTagged ) msg.beginTaggedAnswer( id, seq );
+    else               msg.beginAnswer();
+    csWorkloadFields( msg, cmd, true, *this );
+    msg.end();
+    memcpy( mUnit + mUnitLength, msg.buffer(), msg.length() );
+    mUnitLength += msg.length();
+    mAnswers++;
+    }
+
+  //Шум
+  if( random( 100 ) < mMix.mNoisePercent )
+    for( int n = 1 + random( 8 ); n > 0; n-- )
+      mUnit[mUnitLength++] = static_cast<char>( random() );
+
+  //Искажение байтов, промежутки между ошибками равномерны со средним 10^6 / mErrorPpm
+  if( mMix.mErrorPpm ) {
+    while( mNextError < static_cast<uint32_t>(mUnitLength) ) {
+      mUnit[mNextError] ^= 1 << random( 8 );
+      mErrors++;
+      mNextError += 1 + random( 2000000 / mMix.mErrorPpm );
+      }
+    mNextError -= mUnitLength;
+    }
+  mUnitPtr = 0;
+  }
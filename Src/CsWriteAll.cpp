@@ -0,0 +1,44 @@
+#include "CsWriteAll.hpp"
+
+
+//!
+//! \brief answer Обработать ответ на проверочный запрос
+//! \param value  Прочитанное значение параметра
+//!
+void CsWriteAll::answer(int value)
+  {
+  if( mCurrent < 0 ) return;
+  if( value != mValue )
+    mFailed |= 1 << mCurrent;
+  mPending &= ~(1 << mCurrent);
+  mCurrent = -1;
+  }
+
+
+
+
+//!
+//! \brief timeout Сообщить об отсутствии ответа на проверочный запрос
+//!
+void CsWriteAll::timeout()
+  {
+  if( mCurrent < 0 ) return;
+  mFailed  |= 1 << mCurrent;
+  mPending &= ~(1 << mCurrent);
+  mCurrent = -1;
+  }
+
+
+
+
+//!
+//! \brief next Возвращает идентификатор следующего устройства для проверочного чтения
+//! \return     Идентификатор устройства или -1, если проверка завершена
+//!
+int CsWriteAll::next() const
+  {
+  for( int id = 0; id < CS_ID_BROADCAST; id++ )
+    if( mPending & (1 << id) )
+      return id;
+  return -1;
+  }
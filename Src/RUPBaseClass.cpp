@@ -2,345 +2,12 @@
 
 
 //!
-//! \brief addIntN Добавить N-битное значение
-//! \param val     Значение
-//! \param bits    Количество бит значения
-//!
-void CsMessageOut::addIntN(int val, int bits)
-  {
-  //Начальная часть
-  val &= 0xffffffffu >> (32 - bits);
-  //Добавляем биты в текущий байт
-  mBuffer[mPtr] |= (val << mUsedBits) | 0x80;
-
-  //Количество битов добавленных выше
-  int appendedBits = (bits < 7 ? bits : 7) - mUsedBits;
-  val >>= appendedBits;
-  bits -= appendedBits;
-
-  mUsedBits += appendedBits;
-  if( mUsedBits >= 7 ) {
-    mUsedBits = 0;
-    mPtr++;
-    }
-
-  //Целая часть
-  while( bits > 7 ) {
-    mBuffer[mPtr++] = val | 0x80;
-    val >>= 7;
-    bits -= 7;
-    }
-
-  //Заключительная часть
-  if( bits ) {
-    mUsedBits = bits;
-    mBuffer[mPtr] = (val & (0xff >> (8 - bits))) | 0x80;
-    }
-  }
-
-
-
-//!
-//! \brief addInt8 Добавить 8-битное значение
-//! \param val 8-битное значение
-//!
-void CsMessageOut::addInt8(int val)
-  {
-  //Добавляем биты в текущий байт
-  mBuffer[mPtr++] |= (val << mUsedBits) | 0x80;
-
-  //Количество битов добавленных выше
-  int bits = 7 - mUsedBits;
-
-  //Количество использованных битов в новом байте
-  mUsedBits = 8 - bits;
-  mBuffer[mPtr] = ((val & 0xff) >> bits) | 0x80;
-  if( mUsedBits == 7 ) {
-    mPtr++;
-    mBuffer[mPtr] = 0;
-    mUsedBits = 0;
-    }
-  }
-
-
-
-//!
-//! \brief addInt16 Добавить 16-битное значение
-//! \param val 16-битное значение
-//!
-void CsMessageOut::addInt16(int val)
-  {
-  addInt8(val);
-  addInt8(val >> 8);
-  }
-
-
-
-
-//!
-//! \brief addInt32 Добавить 32-битное значение
-//! \param val 32-битное значение
-//!
-void CsMessageOut::addInt32(int val)
-  {
-  addInt8(val);
-  addInt8(val >> 8);
-  addInt8(val >> 16);
-  addInt8(val >> 24);
-  }
-
-
-
-
-//!
-//! \brief addFloat Добавить 32-битное с плавающей точкой
-//! \param val      32-битное с плавающей точкой
-//!
-void CsMessageOut::addFloat(float val)
-  {
-  addInt32( floatToUInt(val) );
-  }
-
-
-
-
-//!
-//! \brief addBlock Добавить блок байтов
-//! \param block    Блок байтов
-//! \param size     Размер блока
-//!
-void CsMessageOut::addBlock(const char *block, int size)
-  {
-  while( size-- )
-    addInt8( *block++ );
-  }
-
-
-
-
-//!
-//! \brief beginQuery Инициализация буфера командой cmd. После инициализации можно добавлять данные
-//! \param cmd        Формируемая команда
-//! \param id         Идентификатор устройства, которому адресована данная команда
-//!
-void CsMessageOut::beginQuery(char cmd, int id)
-  {
-  mUsedBits = 0;
-  mPtr = 1;
-  mBuffer[0] = ((cmd << 4) & 0x70) | (id & 0xf);
-  mBuffer[1] = 0;
-  }
-
-
-
-//!
-//! \brief beginAnswer Инициализация буфера для ответа. После инициализации можно добавлять данные
-//!
-void CsMessageOut::beginAnswer()
-  {
-  mUsedBits = 0;
-  mPtr = 0;
-  mBuffer[0] = 0;
-  }
-
-
-
-
-//!
-//! \brief hostBeginQuery Инициализация буфера командой cmd. После инициализации можно добавлять данные
-//! \param cmd            Формируемая команда
-//!
-void CsMessageOut::hostBeginQuery(char cmd)
-  {
-  mUsedBits = 0;
-  mPtr = 1;
-  mBuffer[0] = ((cmd) & 0x7f);
-  mBuffer[1] = 0;
-  }
-
-
-
-
-//!
-//! \brief hostEnd Завершение формирования команды, дописывание контрольной суммы и символа \n
-//!
-void CsMessageOut::hostEnd()
-  {
-  //Завершаем и КС
-  end();
-  mBuffer[mPtr++] = '\n';
-  mBuffer[mPtr] = 0;
-  }
-
-
-
-
-//!
-//! \brief end Завершение формирования команды и дописывание контрольной суммы
-//!
-void CsMessageOut::end()
-  {
-  if( mUsedBits ) mPtr++;
-  mBuffer[mPtr] = crc( mBuffer, mPtr ) | 0x80;
-  mBuffer[++mPtr] = 0;
-  }
-
-
-
-//!
-//! \brief makeQueryControl Сформировать команду "Управление"
-//! \param id               Идентификатор устройства
-//! \param value            Значение управления
-//!
-void CsMessageOut::makeQueryControl(int id, int value)
-  {
-  beginQuery( CS_CMD_MSG_CONTROL, id );
-  addInt16( value );
-  end();
-  }
-
-
-
-
-//!
-//! \brief makeAnswerControl Сформировать ответ на команду "Управление"
-//! \param angle             Текущий угол сервы
-//! \param moment            Текущий момент
-//!
-void CsMessageOut::makeAnswerControl(int angle, int moment)
-  {
-  beginAnswer();
-  addInt16( angle );
-  addInt16( moment );
-  end();
-  }
-
-
-
-
-
-//!
-//! \brief makeQueryInfo Сформировать команду "Получить информацию"
-//! \param id            Идентификатор устройства
-//!
-void CsMessageOut::makeQueryInfo(int id)
-  {
-  beginQuery( CS_CMD_MSG_INFO, id );
-  end();
-  }
-
-
-
-//!
-//! \brief makeAnswerInfo  Сформировать ответ на команду "Получить информацию"
-//! \param val0            Значение 0
-//! \param val1            Значение 1
-//! \param val2            Значение 2
-//!
-void CsMessageOut::makeAnswerInfo(int val0, int val1, int val2)
-  {
-  beginAnswer();
-  addInt16( val0 );
-  addInt16( val1 );
-  addInt16( val2 );
-  end();
-  }
-
-
-
-
-
-//!
-//! \brief makeQueryWrite Сформировать команду "Запись параметра"
-//! \param id             Идентификатор устройства
-//! \param index          Индекс параметра
-//! \param value          Значение параметра
-//!
-void CsMessageOut::makeQueryWrite(int id, int index, int value)
-  {
-  beginQuery( CS_CMD_MSG_WRITE, id );
-  addInt16( index );
-  addInt32( value );
-  end();
-  }
-
-
-
-
-//!
-//! \brief makeAnswerWrite Сформировать ответ на команду "Запись параметра"
-//! \param value           Значение, записанное в параметр
-//!
-void CsMessageOut::makeAnswerWrite(int value)
-  {
-  beginAnswer();
-  addInt32( value );
-  end();
-  }
-
-
-
-
-//!
-//! \brief makeQueryRead Сформировать команду "Чтение параметра"
-//! \param id            Идентификатор устройства
-//! \param index         Индекс параметра
-//!
-void CsMessageOut::makeQueryRead(int id, int index)
-  {
-  beginQuery( CS_CMD_MSG_READ, id );
-  addInt16( index );
-  end();
-
-//  mBuffer[0] = 0xff;
-//  mBuffer[1] = 0xfe;
-////  mBuffer[2] = 0xfc;
-//  mPtr = 2;
-  }
-
-
-
-
-//!
-//! \brief makeAnswerRead Сформировать ответ на команду "Чтение параметра"
-//! \param index          Индекс параметра
-//! \param value          Значение параметра
-//!
-void CsMessageOut::makeAnswerRead(int value)
-  {
-  beginAnswer();
-  //addInt16( index );
-  addInt32( value );
-  end();
-  }
-
-
-
-
-//!
-//! \brief makeQueryFlash Сформировать команду "Прошивка"
-//! \param id             Идентификатор устройства
-//! \param adrOrCmd       Адрес прошивки или команда
-//! \param value          Значение прошивки
-//!
-void CsMessageOut::makeQueryFlash(int id, int adrOrCmd, int value)
-  {
-  beginQuery( CS_CMD_MSG_FLASH, id );
-  addInt32(adrOrCmd);
-  addInt32(value);
-  end();
-  }
-
-
-
-
-//!
-//! \brief crc  Вычисление контрольной суммы для блока данных
+//! \brief csMessageCrc Вычисление контрольной суммы для блока данных
 //! \param buf  Буфер с данными, на которых вычисляется контрольная сумма
 //! \param size Размер данных в байтах
 //! \return     Контрольная сумма
 //!
-int CsMessageOut::crc(const char *buf0, int size0, const char *buf1, int size1)
+int csMessageCrc(const char *buf0, int size0, const char *buf1, int size1)
   {
   /*
     Name  : CRC-8
@@ -402,7 +69,7 @@ int CsMessageOut::crc(const char *buf0, int size0, const char *buf1, int size1)
 
 
 
-CsMessageIn::CsMessageIn(const char *buf, short start, short size, int ptr ) :
+CsMessageIn::CsMessageIn(const char *buf, int start, int size, int ptr ) :
   mBuffer(buf),
   mStart(start),
   mBufSize(size),
@@ -517,6 +184,21 @@ int CsMessageIn::getInt32()
 
 
 
+
+//!
+//! \brief getInt64 Извлекает 64-битное число
+//! \return 64-битное число
+//!
+int64_t CsMessageIn::getInt64()
+  {
+  uint64_t low  = static_cast<uint32_t>( getInt32() );
+  uint64_t high = static_cast<uint32_t>( getInt32() );
+  return static_cast<int64_t>( (high << 32) | low );
+  }
+
+
+
+
 //!
 //! \brief checkCrc Проверить совпадение контрольной суммы
 //! \param length   Длина сообщения
@@ -531,12 +213,12 @@ bool CsMessageIn::checkCrc(int length) const
   int size0 = mBufSize - mStart;
   if( size0 >= length ) {
     //Все влезло в первую часть
-    int crc0 = (CsMessageOut::crc( mBuffer + mStart, length ) | 0x80);
+    int crc0 = (csMessageCrc( mBuffer + mStart, length ) | 0x80);
     int crc1 = at(length) & 0xff;
     return crc0 == crc1;
     }
   //Нужно считать по двум частям
   int size1 = length - size0;
-  return (CsMessageOut::crc( mBuffer + mStart, size0, mBuffer, size1 ) | 0x80) == at(length);
+  return (csMessageCrc( mBuffer + mStart, size0, mBuffer, size1 ) | 0x80) == (at(length) & 0xff);
   }
 
@@ -0,0 +1,170 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     cscobstest - проверка кодирования и декодирования COBS
+
+     Использование
+       cscobstest
+     Проверяются:
+       - эталонные кадры COBS: пустые данные, данные из нулевых байтов, блоки
+         из 254 и 255 ненулевых байтов и нулевой байт на границе блока;
+       - кодирование и обратное декодирование данных длиной до 1024 байтов
+         с разной долей нулевых байтов: кадр не содержит нулевых байтов кроме
+         разделителя, не превышает CS_COBS_MAX_LENGTH и декодируется в исходные данные;
+       - отказ декодирования при нулевом коде, блоке за концом кадра и малом приемнике;
+       - сообщение CsCobsOut, принятое CsCobsIn, и отказ при ошибке КС.
+     При любой ошибке программа завершается с кодом 1.
+   */
+#include "CsCobs.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+//Максимальная длина проверяемых данных
+#define CS_TEST_MAX   1024
+
+static int csFailures;
+
+
+
+
+//!
+//! \brief csFail Вывести сообщение об ошибке
+//! \param name   Название случая
+//! \param size   Длина данных
+//!
+static void csFail( const char *name, int size )
+  {
+  printf( "FAIL: %s (size %d)\n", name, size );
+  csFailures++;
+  }
+
+
+
+
+//!
+//! \brief csRoundTrip Закодировать данные, проверить кадр и декодировать обратно
+//! \param name        Название случая
+//! \param src         Исходные данные
+//! \param size        Длина данных
+//! \param expect      Ожидаемый кадр, включая разделитель, или nullptr
+//! \param expectSize  Длина ожидаемого кадра
+//!
+static void csRoundTrip( const char *name, const char *src, int size, const char *expect = nullptr, int expectSize = 0 )
+  {
+  static char frame[CS_COBS_MAX_LENGTH(CS_TEST_MAX)];
+  static char back[CS_TEST_MAX];
+  int len = csCobsEncode( src, size, frame );
+  if( len < 2 || len > CS_COBS_MAX_LENGTH(size) || frame[len - 1] != 0 || memchr( frame, 0, len - 1 ) != nullptr ) {
+    csFail( name, size );
+    return;
+    }
+  if( expect != nullptr && (len != expectSize || memcmp( frame, expect, len ) != 0) ) {
+    csFail( name, size );
+    return;
+    }
+  //Декодирование в приемник точно по размеру данных
+  int got = csCobsDecode( frame, len - 1, back, size );
+  if( got != size || memcmp( back, src, size ) != 0 )
+    csFail( name, size );
+  }
+
+
+
+
+int main()
+  {
+  static char src[CS_TEST_MAX];
+  static char expect[CS_COBS_MAX_LENGTH(CS_TEST_MAX)];
+
+  //Пустые данные
+  csRoundTrip( "empty", src, 0, "\x01\x00", 2 );
+
+  //Данные из нулевых байтов: каждый нулевой байт - блок с кодом 1
+  memset( src, 0, sizeof(src) );
+  csRoundTrip( "one zero", src, 1, "\x01\x01\x00", 3 );
+  csRoundTrip( "two zeros", src, 2, "\x01\x01\x01\x00", 4 );
+  for( int size = 3; size <= 600; size++ ) {
+    memset( expect, 1, size + 1 );
+    expect[size + 1] = 0;
+    csRoundTrip( "all zeros", src, size, expect, size + 2 );
+    }
+
+  //Нулевые байты внутри и в конце данных
+  csRoundTrip( "inner zero", "\x11\x22\x00\x33", 4, "\x03\x11\x22\x02\x33\x00", 6 );
+  csRoundTrip( "trailing zeros", "\x11\x00\x00\x00", 4, "\x02\x11\x01\x01\x01\x00", 6 );
+
+  //254 ненулевых байта: один полный блок без завершающего кода
+  for( int i = 0; i < 254; i++ ) src[i] = i + 1;
+  expect[0] = '\xff';
+  memcpy( expect + 1, src, 254 );
+  expect[255] = 0;
+  csRoundTrip( "254 non-zero", src, 254, expect, 256 );
+
+  //255 ненулевых байтов: полный блок и блок из одного байта
+  src[254] = '\xff';
+  expect[255] = 2;
+  expect[256] = '\xff';
+  expect[257] = 0;
+  csRoundTrip( "255 non-zero", src, 255, expect, 258 );
+
+  //Нулевой байт после полного блока: полный блок не подразумевает нулевой байт,
+  //поэтому нулевой байт кодируется отдельным блоком, за которым следует пустой последний блок
+  src[254] = 0;
+  expect[255] = 1;
+  expect[256] = 1;
+  expect[257] = 0;
+  csRoundTrip( "zero after 254 non-zero", src, 255, expect, 258 );
+
+  //Нулевой байт перед 254 ненулевыми
+  src[0] = 0;
+  for( int i = 1; i < 255; i++ ) src[i] = i;
+  expect[0] = 1;
+  expect[1] = '\xff';
+  memcpy( expect + 2, src + 1, 254 );
+  expect[256] = 0;
+  csRoundTrip( "zero before 254 non-zero", src, 255, expect, 257 );
+
+  //Длинные ненулевые данные: несколько полных блоков
+  for( int size = 253; size <= 1024; size++ ) {
+    for( int i = 0; i < size; i++ ) src[i] = 1 + i % 255;
+    csRoundTrip( "long non-zero", src, size );
+    }
+
+  //Случайные данные с разной долей нулевых байтов
+  unsigned seed = 1;
+  for( int density = 0; density <= 100; density += 10 )
+    for( int n = 0; n < 200; n++ ) {
+      int size = rand_r( &seed ) % (CS_TEST_MAX + 1);
+      for( int i = 0; i < size; i++ )
+        src[i] = static_cast<int>( rand_r( &seed ) % 100 ) < density ? 0 : 1 + rand_r( &seed ) % 255;
+      csRoundTrip( "random", src, size );
+      }
+
+  //Ошибки кадра
+  char out[8];
+  if( csCobsDecode( "\x02\x11\x00\x33", 4, out, sizeof(out) ) != -1 ) csFail( "zero code", 4 );
+  if( csCobsDecode( "\x05\x11\x22", 3, out, sizeof(out) ) != -1 ) csFail( "block past frame end", 3 );
+  if( csCobsDecode( "\x03\x11\x22\x02\x33", 5, out, 3 ) != -1 ) csFail( "small destination", 5 );
+
+  //Сообщение обмена с хостом
+  CsCobsOut msg;
+  msg.hostBeginQuery( CS_CMD_MSG_WRITE );
+  msg.addInt16( 0 );
+  msg.addInt32( -1 );
+  msg.addInt64( 0x0102030400000000ll );
+  msg.hostEnd();
+  CsCobsIn in( msg.buffer(), msg.length() - 1 );
+  if( !in.valid() || in.hostCmd() != CS_CMD_MSG_WRITE || in.length() != 15 ||
+      in.getInt16() != 0 || in.getInt32() != -1 || in.getInt64() != 0x0102030400000000ll )
+    csFail( "host message", msg.length() );
+  //Ошибка КС
+  char bad[CS_COBS_MAX_LENGTH(64)];
+  memcpy( bad, msg.buffer(), msg.length() );
+  bad[msg.length() - 3] ^= 0x40;
+  if( CsCobsIn( bad, msg.length() - 1 ).valid() ) csFail( "host message crc", msg.length() );
+
+  if( csFailures ) return 1;
+  printf( "OK\n" );
+  return 0;
+  }
@@ -0,0 +1,155 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     csencodetest - проверка кодирования сообщений CsMessageOutT
+
+     Использование
+       csencodetest
+     Сообщения, сформированные комплексными операциями и добавлением полей,
+     сравниваются побайтно с эталоном. Эталонные байты получены кодировщиком
+     CsMessageOut до перевода на шаблон CsMessageOutT с размером буфера.
+     Проверяются CsMessageOut, CsMessageOut256 и буферы по размеру команды
+     CsQueryOut/CsAnswerOut. При любом расхождении программа завершается с кодом 1.
+   */
+#include "RUPBaseClass.hpp"
+
+#include <stdio.h>
+#include <string.h>
+
+//Эталонное сообщение
+struct CsTestGolden {
+    int           mLength;     //!< Длина сообщения
+    unsigned char mBytes[16];  //!< Байты сообщения
+  };
+
+static const CsTestGolden csGolden[] = {
+  {  5, { 0x00, 0x80, 0x80, 0x80, 0xdb } },
+  {  5, { 0x05, 0xae, 0xf6, 0x83, 0xf2 } },
+  {  5, { 0x0f, 0xff, 0xff, 0x81, 0xd8 } },
+  {  6, { 0x80, 0x80, 0xfe, 0xff, 0x80, 0xa7 } },
+  {  6, { 0x81, 0x80, 0xfc, 0xff, 0x8f, 0xd6 } },
+  {  2, { 0x17, 0xf8 } },
+  {  8, { 0xe4, 0x80, 0xe0, 0xf9, 0x8f, 0xa6, 0x9d, 0xd6 } },
+  {  9, { 0x53, 0x8c, 0x80, 0xec, 0xff, 0xff, 0xff, 0xbf, 0x8a } },
+  {  6, { 0xff, 0xff, 0x81, 0x80, 0x80, 0x9d } },
+  {  5, { 0x69, 0xff, 0x87, 0x80, 0xfc } },
+  {  6, { 0x80, 0x86, 0xfe, 0xff, 0x8f, 0x80 } },
+  { 12, { 0x72, 0xb4, 0xa4, 0x80, 0x80, 0x90, 0xff, 0xff, 0xff, 0xff, 0x81, 0xe3 } },
+  { 13, { 0x54, 0xfd, 0xf1, 0xd9, 0xa2, 0xa3, 0x82, 0x80, 0x80, 0xd0, 0x80, 0x82, 0xb4 } },
+  {  8, { 0x06, 0x81, 0xfe, 0x81, 0xfc, 0x8f, 0xee, 0x0a } }
+  };
+
+static int csFailures;
+
+
+
+
+//!
+//! \brief csEncodeCase Сформировать проверяемое сообщение
+//! \param n            Номер случая
+//! \param msg          Кодировщик
+//! \return             false, если случая с таким номером нет
+//!
+template <class CsMessageOutTmpl>
+static bool csEncodeCase( int n, CsMessageOutTmpl &msg )
+  {
+  switch( n ) {
+    case 0  : msg.makeQueryControl( 0, 0 ); break;
+    case 1  : msg.makeQueryControl( 5, -1234 ); break;
+    case 2  : msg.makeQueryControl( 15, 32767 ); break;
+    case 3  : msg.makeAnswerControl( -32768, 4095 ); break;
+    case 4  : msg.makeAnswerControl( 1, -1 ); break;
+    case 5  : msg.makeQueryInfo( 7 ); break;
+    case 6  : msg.makeAnswerInfo( 100, -200, 30000 ); break;
+    case 7  : msg.makeQueryWrite( 3, 12, -5 ); break;
+    case 8  : msg.makeAnswerWrite( 0x7fff ); break;
+    case 9  : msg.makeQueryRead( 9, 1023 ); break;
+    case 10 : msg.makeAnswerRead( -32000 ); break;
+    case 11 : msg.makeQueryFlash( 2, 0x1234, -7 ); break;
+    case 12 :
+      msg.beginQuery( CS_CMD_MSG_WRITE, 4 );
+      msg.addInt8( -3 );
+      msg.addInt32( 0x12345678 );
+      msg.addFloat( 3.25f );
+      msg.addIntN( 5, 3 );
+      msg.end();
+      break;
+    case 13 :
+      msg.hostBeginQuery( CS_CMD_MSG_READ );
+      msg.addBlock( "\x01\x7f\x80\xff", 4 );
+      msg.hostEnd();
+      break;
+    default : return false;
+    }
+  return true;
+  }
+
+
+
+
+//!
+//! \brief csCompare Сравнить сообщение с эталоном
+//! \param name      Название кодировщика
+//! \param n         Номер эталона
+//! \param msg       Кодировщик со сформированным сообщением
+//!
+template <class CsMessageOutTmpl>
+static void csCompare( const char *name, int n, const CsMessageOutTmpl &msg )
+  {
+  const CsTestGolden &g = csGolden[n];
+  if( msg.length() != g.mLength || memcmp( msg.buffer(), g.mBytes, g.mLength ) != 0 ) {
+    printf( "FAIL: %s, case %d\n", name, n );
+    csFailures++;
+    }
+  }
+
+
+
+
+int main()
+  {
+  int count = sizeof(csGolden) / sizeof(csGolden[0]);
+  for( int n = 0; n < count; n++ ) {
+    CsMessageOut msg;
+    CsMessageOut256 msg256;
+    if( !csEncodeCase( n, msg ) || !csEncodeCase( n, msg256 ) ) {
+      printf( "FAIL: case %d missing\n", n );
+      return 1;
+      }
+    csCompare( "CsMessageOut", n, msg );
+    csCompare( "CsMessageOut256", n, msg256 );
+    }
+
+  //Буферы по размеру команды
+  CsQueryOut<CS_CMD_MSG_CONTROL> control;
+  control.makeQueryControl( 5, -1234 );
+  csCompare( "CsQueryOut<CONTROL>", 1, control );
+  CsAnswerOut<CS_CMD_MSG_CONTROL> controlAnswer;
+  controlAnswer.makeAnswerControl( -32768, 4095 );
+  csCompare( "CsAnswerOut<CONTROL>", 3, controlAnswer );
+  CsQueryOut<CS_CMD_MSG_INFO> info;
+  info.makeQueryInfo( 7 );
+  csCompare( "CsQueryOut<INFO>", 5, info );
+  CsAnswerOut<CS_CMD_MSG_INFO> infoAnswer;
+  infoAnswer.makeAnswerInfo( 100, -200, 30000 );
+  csCompare( "CsAnswerOut<INFO>", 6, infoAnswer );
+  CsQueryOut<CS_CMD_MSG_WRITE> write;
+  write.makeQueryWrite( 3, 12, -5 );
+  csCompare( "CsQueryOut<WRITE>", 7, write );
+  CsAnswerOut<CS_CMD_MSG_WRITE> writeAnswer;
+  writeAnswer.makeAnswerWrite( 0x7fff );
+  csCompare( "CsAnswerOut<WRITE>", 8, writeAnswer );
+  CsQueryOut<CS_CMD_MSG_READ> read;
+  read.makeQueryRead( 9, 1023 );
+  csCompare( "CsQueryOut<READ>", 9, read );
+  CsAnswerOut<CS_CMD_MSG_READ> readAnswer;
+  readAnswer.makeAnswerRead( -32000 );
+  csCompare( "CsAnswerOut<READ>", 10, readAnswer );
+  CsQueryOut<CS_CMD_MSG_FLASH> flash;
+  flash.makeQueryFlash( 2, 0x1234, -7 );
+  csCompare( "CsQueryOut<FLASH>", 11, flash );
+
+  if( csFailures ) return 1;
+  printf( "OK\n" );
+  return 0;
+  }
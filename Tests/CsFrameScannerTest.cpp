@@ -0,0 +1,193 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     csframetest - проверка выделения запросов CsFrameScanner
+
+     Использование
+       csframetest
+     В циклический буфер записываются запросы, сформированные CsMessageOut,
+     и проверяются выделенные запросы, количество ошибок КС и индекс
+     продолжения разбора для случаев:
+       - запросы, переходящие через конец циклического буфера;
+       - запрос, прерванный заголовком следующего запроса, в том числе когда
+         принятых данных меньше длины прерванного запроса;
+       - запрос с ошибкой КС;
+       - неполный запрос в конце принятых данных;
+       - запросы с меткой для устройств из маски tagged;
+       - ограничение разбора setLimit при разборе по частям с перекрытием.
+     При любой ошибке программа завершается с кодом 1.
+   */
+#include "RUPBaseClass.hpp"
+
+#include <stdio.h>
+
+//Размер циклического буфера проверки
+#define CS_TEST_RING   32
+
+//Ожидаемый выделенный запрос
+struct CsTestFrame {
+    int mCmd;    //!< Команда
+    int mId;     //!< Идентификатор устройства
+    int mStart;  //!< Индекс заголовка в циклическом буфере
+    int mLength; //!< Полная длина запроса
+    int mValue;  //!< Значение управления (CS_BIT_CONTROL_VALUE) или -1, если не проверяется
+  };
+
+//Циклический буфер приема
+struct CsTestRing {
+    char mBuffer[CS_TEST_RING]; //!< Принятые байты
+    int  mTail;                 //!< Индекс, по которому будет записан следующий байт
+
+    void put( const char *data, int size )
+      {
+      for( int i = 0; i < size; i++ ) {
+        mBuffer[mTail] = data[i];
+        mTail = (mTail + 1) % CS_TEST_RING;
+        }
+      }
+
+    void put( const CsMessageOut &msg ) { put( msg.buffer(), msg.length() ); }
+  };
+
+static int csFailures;
+
+
+
+//!
+//! \brief csCheck Выделить запросы и сравнить с ожидаемыми
+//! \param name    Название случая
+//! \param ring    Циклический буфер
+//! \param head    Индекс первого непрочитанного байта
+//! \param tagged  Маска устройств, запросы к которым передаются с меткой
+//! \param expect  Ожидаемые запросы
+//! \param count   Количество ожидаемых запросов
+//! \param errors  Ожидаемое количество ошибок КС
+//! \param resume  Ожидаемый индекс продолжения разбора
+//! \param limit   Ограничение разбора (setLimit) или -1
+//!
+static void csCheck( const char *name, const CsTestRing &ring, int head, uint16_t tagged,
+                     const CsTestFrame *expect, int count, int errors, int resume, int limit = -1 )
+  {
+  CsFrameScanner scan = csFrames( ring.mBuffer, CS_TEST_RING, head, ring.mTail, tagged );
+  if( limit >= 0 ) scan.setLimit( limit );
+  int n = 0;
+  bool ok = true;
+  for( const CsFrame &frame : scan ) {
+    if( n >= count ) { ok = false; break; }
+    const CsTestFrame &e = expect[n++];
+    if( frame.cmd() != e.mCmd || frame.id() != e.mId || frame.start() != e.mStart || frame.length() != e.mLength ||
+        (e.mValue >= 0 && frame.getInt16At( CS_BIT_CONTROL_VALUE ) != e.mValue) )
+      ok = false;
+    }
+  if( !ok || n != count || scan.errors() != errors || scan.head() != resume ) {
+    printf( "FAIL: %s (frames %d of %d, errors %d of %d, head %d of %d)\n", name, n, count, scan.errors(), errors, scan.head(), resume );
+    csFailures++;
+    }
+  }
+
+
+
+
+int main()
+  {
+  CsMessageOut control, info, read;
+  control.makeQueryControl( 3, 1000 );
+  info.makeQueryInfo( 4 );
+  read.makeQueryRead( 5, 12 );
+
+  //Запросы через конец буфера, байты данных без заголовка пропускаются
+  {
+  CsTestRing ring = { {}, 30 };
+  ring.put( control );
+  ring.put( "\x80\x80\x80", 3 );
+  ring.put( info );
+  ring.put( read );
+  CsTestFrame expect[] = { { CS_CMD_MSG_CONTROL, 3, 30, 5, 1000 }, { CS_CMD_MSG_INFO, 4, 6, 2, -1 }, { CS_CMD_MSG_READ, 5, 8, 5, -1 } };
+  csCheck( "wraparound", ring, 30, 0, expect, 3, 0, ring.mTail );
+  }
+
+  //Запрос прерван заголовком: разбор продолжается с прервавшего заголовка
+  {
+  CsTestRing ring = { {}, 0 };
+  ring.put( control.buffer(), 2 );
+  ring.put( control );
+  ring.put( info );
+  CsTestFrame expect[] = { { CS_CMD_MSG_CONTROL, 3, 2, 5, 1000 }, { CS_CMD_MSG_INFO, 4, 7, 2, -1 } };
+  csCheck( "truncated frame", ring, 0, 0, expect, 2, 0, ring.mTail );
+  }
+
+  //Прерванный запрос длиннее всех принятых данных: следующий запрос выделяется сразу
+  {
+  CsTestRing ring = { {}, 10 };
+  ring.put( control.buffer(), 2 );
+  ring.put( info );
+  CsTestFrame expect[] = { { CS_CMD_MSG_INFO, 4, 12, 2, -1 } };
+  csCheck( "truncated frame before short tail", ring, 10, 0, expect, 1, 0, ring.mTail );
+  }
+
+  //Заголовок в середине прерванного запроса через конец буфера
+  {
+  CsTestRing ring = { {}, 29 };
+  ring.put( control.buffer(), 3 );
+  ring.put( control );
+  CsTestFrame expect[] = { { CS_CMD_MSG_CONTROL, 3, 0, 5, 1000 } };
+  csCheck( "truncated frame at wrap", ring, 29, 0, expect, 1, 0, ring.mTail );
+  }
+
+  //Ошибка КС: запрос пропускается, следующий выделяется
+  {
+  CsMessageOut bad;
+  bad.makeQueryControl( 3, 1000 );
+  CsTestRing ring = { {}, 20 };
+  ring.put( bad.buffer(), bad.length() - 1 );
+  ring.put( "\xff", 1 );
+  ring.put( control );
+  CsTestFrame expect[] = { { CS_CMD_MSG_CONTROL, 3, 25, 5, 1000 } };
+  csCheck( "crc error", ring, 20, 0, expect, 1, 1, ring.mTail );
+  }
+
+  //Неполный запрос в конце данных остается непрочитанным
+  {
+  CsTestRing ring = { {}, 26 };
+  ring.put( info );
+  ring.put( control.buffer(), 3 );
+  CsTestFrame expect[] = { { CS_CMD_MSG_INFO, 4, 26, 2, -1 } };
+  csCheck( "incomplete tail", ring, 26, 0, expect, 1, 0, 28 );
+  //Запрос выделяется после приема остальных байтов
+  ring.put( control.buffer() + 3, control.length() - 3 );
+  CsTestFrame rest[] = { { CS_CMD_MSG_CONTROL, 3, 28, 5, 1000 } };
+  csCheck( "completed tail", ring, 28, 0, rest, 1, 0, ring.mTail );
+  }
+
+  //Ограничение разбора: запрос с заголовком до границы дочитывается за ней,
+  //запросы и ошибки КС с заголовком за границей не разбираются
+  {
+  CsMessageOut bad;
+  bad.makeQueryControl( 3, 1000 );
+  CsTestRing ring = { {}, 0 };
+  ring.put( info );
+  ring.put( control );
+  ring.put( bad.buffer(), bad.length() - 1 );
+  ring.put( "\xff", 1 );
+  ring.put( info );
+  CsTestFrame expect[] = { { CS_CMD_MSG_INFO, 4, 0, 2, -1 }, { CS_CMD_MSG_CONTROL, 3, 2, 5, 1000 } };
+  csCheck( "limit", ring, 0, 0, expect, 2, 0, 7, 4 );
+  }
+
+  //Запросы с меткой к устройствам из маски и без метки к остальным
+  {
+  CsMessageOut tagged;
+  tagged.beginTaggedQuery( CS_CMD_MSG_CONTROL, 3, 6 );
+  tagged.addInt16( 200 );
+  tagged.end();
+  CsTestRing ring = { {}, 28 };
+  ring.put( tagged );
+  ring.put( info );
+  CsTestFrame expect[] = { { CS_CMD_MSG_CONTROL, 3, 28, 6, 200 }, { CS_CMD_MSG_INFO, 4, 2, 2, -1 } };
+  csCheck( "tagged", ring, 28, 1 << 3, expect, 2, 0, ring.mTail );
+  }
+
+  if( csFailures ) return 1;
+  printf( "OK\n" );
+  return 0;
+  }
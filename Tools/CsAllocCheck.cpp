@@ -0,0 +1,212 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     csalloccheck - проверка отсутствия выделений динамической памяти
+     в установившемся режиме обмена
+
+     Использование
+       csalloccheck [циклов] [устройств]
+     Программа компонуется с RUPAllocGuard. Хост и эмулятор шины работают
+     в одном потоке. В каждом цикле хост формирует команды управления и запрос
+     информации одному из устройств (CsControlCadence, CsMessageOut) и передает
+     их через CsTxCoalescer. Эмулятор выделяет запросы (CsFrameScanner) и
+     добавляет в линию ответы. Хост разбирает ответы пакетно (csDecodeControlAnswers,
+     csDecodeInfoAnswers), обновляет CsStateStore, агрегирует телеметрию
+     (CsTelemetryAgg), учитывает время ожидания (CsRttTable). Поток линии
+     одновременно прослушивается анализатором CsSniffer с учетом загрузки CsBusLoad.
+
+     После прогрева включается контроль выделений. Если после прогрева произошло
+     хотя бы одно выделение, выводятся стеки вызовов и программа завершается
+     с кодом 1. В конце выводится время одного цикла.
+   */
+#include "CsAllocGuard.hpp"
+#include "CsBatchDecode.hpp"
+#include "CsBusLoad.hpp"
+#include "CsBusyPoll.hpp"
+#include "CsControlCadence.hpp"
+#include "CsRttEstimator.hpp"
+#include "CsTelemetryAgg.hpp"
+#include "CsTxCoalescer.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//Скорость обмена эмулируемой шины, бод
+#define CS_CHECK_BAUD    1000000
+
+//Количество циклов прогрева
+#define CS_CHECK_WARMUP  1000
+
+//Длительность цикла управления, мкс
+#define CS_CHECK_CYCLE   1000
+
+//Размер линии эмулятора (запросы и ответы одного цикла)
+#define CS_CHECK_LINE    1024
+
+//!
+//! \brief The CsCheckBus struct эмулируемая шина: запросы хоста и ответы устройств одного цикла
+//!
+struct CsCheckBus {
+    char mQueries[CS_CHECK_LINE];  //!< Запросы хоста, переданные объединителем
+    int  mQueryLength;             //!< Длина запросов
+    char mLine[CS_CHECK_LINE];     //!< Байты линии: запросы и ответы в порядке передачи
+    int  mLineLength;              //!< Длина линии
+  };
+
+static CsCheckBus              csBus;
+static CsStateStore<1>         csStore;
+static CsTelemetryAgg<1>      *csAgg;
+static CsRttTable<1>           csRtt;
+static uint64_t                csWindows;
+
+
+
+
+//!
+//! \brief csCheckWrite Прием блока запросов от объединителя
+//!
+static void csCheckWrite( void *, const char *data, int size )
+  {
+  memcpy( csBus.mQueries + csBus.mQueryLength, data, size );
+  csBus.mQueryLength += size;
+  }
+
+
+
+
+//!
+//! \brief csCheckWindow Прием окна телеметрии
+//!
+static void csCheckWindow( void *, const CsTelemetryAgg<1>::Window & )
+  {
+  csWindows++;
+  }
+
+
+
+
+//!
+//! \brief csEmulate Эмулятор устройств: ответить на запросы цикла
+//! \param cycle     Номер цикла
+//!
+static void csEmulate( uint32_t cycle )
+  {
+  csBus.mLineLength = 0;
+  for( const CsFrame &query : csFrames( csBus.mQueries, CS_CHECK_LINE, 0, csBus.mQueryLength ) ) {
+    for( int i = 0; i < query.length(); i++ )
+      csBus.mLine[csBus.mLineLength++] = query.at(i);
+    CsMessageOut answer;
+    if( query.cmd() == CS_CMD_MSG_CONTROL )
+      answer.makeAnswerControl( query.getInt16At( CS_BIT_CONTROL_VALUE ), static_cast<int>(cycle & 0x7fff) );
+    else if( query.cmd() == CS_CMD_MSG_INFO )
+      answer.makeAnswerInfo( query.id(), static_cast<int>(cycle & 0x7fff), -query.id() );
+    else
+      continue;
+    memcpy( csBus.mLine + csBus.mLineLength, answer.buffer(), answer.length() );
+    csBus.mLineLength += answer.length();
+    }
+  csBus.mQueryLength = 0;
+  }
+
+
+
+
+//!
+//! \brief csCycle Один цикл управления
+//! \param cycle   Номер цикла
+//! \param devices Количество устройств
+//! \param tx      Объединитель передачи
+//! \param cadence Выбор команды управления
+//! \param sniffer Анализатор линии
+//!
+static void csCycle( uint32_t cycle, int devices, CsTxCoalescer &tx, CsControlCadence &cadence, CsSniffer &sniffer )
+  {
+  uint32_t now = cycle * CS_CHECK_CYCLE;
+  //Передача: управление всем устройствам и запрос информации одному из них
+  for( int id = 0; id < devices; id++ ) {
+    CsMessageOut query;
+    cadence.makeQuery( query, id, static_cast<int>((cycle + id) & 0x3fff) );
+    tx.append( query, now );
+    }
+  CsQueryOut<CS_CMD_MSG_INFO> info;
+  info.makeQueryInfo( cycle % devices );
+  tx.append( info, now );
+  tx.flushCycle();
+  cadence.nextCycle();
+
+  csEmulate( cycle );
+  sniffer.feed( csBus.mLine, csBus.mLineLength, now + csWireTime( csBus.mLineLength, CS_CHECK_BAUD ) );
+
+  //Прием: ответы идут за запросами, пакетный разбор по командам
+  CsFrame controls[CS_DEVICE_COUNT], infos[1];
+  uint8_t controlIds[CS_DEVICE_COUNT], infoIds[1];
+  int     controlCount = 0, infoCount = 0;
+  for( const CsFrame &query : csFrames( csBus.mLine, CS_CHECK_LINE, 0, csBus.mLineLength ) ) {
+    int cmd = query.cmd();
+    CsFrame answer( csBus.mLine, CS_CHECK_LINE, query.start() + query.length(), csAnswerLengths[cmd], 0 );
+    if( csAnswerLengths[cmd] == 0 || !answer.decoder().checkCrc( answer.length() ) ) continue;
+    csRtt.at( 0, query.id() ).sample( cmd, csExchangeTime( cmd, CS_CHECK_BAUD ) + 20 );
+    if( cmd == CS_CMD_MSG_CONTROL ) {
+      controlIds[controlCount] = query.id();
+      controls[controlCount++] = answer;
+      }
+    else if( cmd == CS_CMD_MSG_INFO ) {
+      infoIds[infoCount] = query.id();
+      infos[infoCount++] = answer;
+      }
+    }
+  int16_t angles[CS_DEVICE_COUNT], moments[CS_DEVICE_COUNT], info0[1], info1[1], info2[1];
+  csDecodeControlAnswers( controls, controlCount, angles, moments );
+  csDecodeInfoAnswers( infos, infoCount, info0, info1, info2 );
+  csStore.setControl( 0, controlIds, controlCount, angles, moments, now );
+  for( int i = 0; i < infoCount; i++ )
+    csStore.setInfo( 0, infoIds[i], info0[i], info1[i], info2[i], now );
+  csStore.publish();
+
+  //Телеметрия по согласованной копии опубликованного состояния
+  csAgg->add( csStore, now );
+  }
+
+
+
+
+int main( int argc, char *argv[] )
+  {
+  long cycles  = argc > 1 ? atol( argv[1] ) : 1000000;
+  int  devices = argc > 2 ? atoi( argv[2] ) : 8;
+  if( devices < 1 ) devices = 1;
+  if( devices > CS_ID_BROADCAST ) devices = CS_ID_BROADCAST;
+
+  //Все объекты создаются до прогрева, в том числе выровненные в динамической памяти
+  csAgg = new CsTelemetryAgg<1>( 10 * CS_CHECK_CYCLE, csCheckWindow, nullptr );
+  csRtt.reset( 0, CS_CHECK_BAUD );
+  CsTxCoalescer    tx( csCheckWrite, nullptr, 512 );
+  CsControlCadence cadence( 4, 0x00ff );
+  CsBusLoad        load( CS_CHECK_BAUD );
+  CsSniffer        sniffer( CS_CHECK_BAUD, 0, CsBusLoad::record, &load );
+
+  uint32_t cycle = 0;
+  for( ; cycle < CS_CHECK_WARMUP; cycle++ )
+    csCycle( cycle, devices, tx, cadence, sniffer );
+
+  csAllocArm();
+  uint32_t start = csTimeUs();
+  for( long i = 0; i < cycles; i++, cycle++ )
+    csCycle( cycle, devices, tx, cadence, sniffer );
+  uint32_t elapsed = csTimeUs() - start;
+  uint64_t count = csAllocDisarm();
+
+  printf( "%ld cycles, %d devices: %.3f us per cycle, %llu telemetry windows, bus occupancy %.2f\n",
+          cycles, devices, cycles ? static_cast<double>(elapsed) / cycles : 0.0,
+          static_cast<unsigned long long>(csWindows), load.stat().occupancy() );
+  if( count ) {
+    printf( "FAIL: %llu allocations after warm-up\n", static_cast<unsigned long long>(count) );
+    fflush( stdout );
+    csAllocReport( 1 );
+    return 1;
+    }
+  printf( "OK: no allocations after warm-up\n" );
+  delete csAgg;
+  return 0;
+  }
@@ -0,0 +1,155 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     cspollbench - задержка приема CsBusyPoll при разных политиках опроса
+
+     Использование
+       cspollbench [количество сообщений] [процессор приема]
+     Порт заменяется псевдотерминалом: поток приема CsBusyPoll опрашивает
+     подчиненную сторону, а основной поток через случайные промежутки
+     (100-500 мкс, как ответы устройств в цикле управления) записывает байт
+     в ведущую сторону. Измеряется время от записи до вызова функции
+     обработки для политик:
+       events - прием по событиям (mSpin = 0, mYield = 0);
+       yield  - опрос с уступкой процессора;
+       spin   - непрерывный опрос (политика по умолчанию).
+     Для каждой политики выводятся медиана, 99-й процентиль и максимум
+     задержки, а также доля занятости процессора потоком приема.
+     Непрерывный опрос имеет смысл только на выделенном ядре: при одном
+     доступном процессоре поток записи вытесняется потоком приема.
+   */
+#include "CsBusyPoll.hpp"
+
+#include <algorithm>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+//!
+//! \brief csTimeNs Возвращает монотонное время
+//! \return         Время, нс
+//!
+static uint64_t csTimeNs()
+  {
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+  }
+
+
+
+
+//Состояние измерения, общее для потоков записи и приема
+struct CsBenchState {
+    std::atomic<uint64_t>  mSent;     //!< Время записи последнего байта, нс
+    std::atomic<uint32_t>  mReceived; //!< Количество принятых байтов
+    std::vector<uint32_t>  mTimes;    //!< Задержки приема, нс
+  };
+
+
+
+
+//!
+//! \brief csBenchRx Функция обработки принятых данных: учесть задержку приема
+//! \param context   Состояние измерения
+//! \param size      Количество байтов
+//!
+static void csBenchRx( void *context, const char *, int size, uint32_t )
+  {
+  CsBenchState *st = static_cast<CsBenchState*>(context);
+  uint64_t now = csTimeNs();
+  if( st->mTimes.size() < st->mTimes.capacity() )
+    st->mTimes.push_back( static_cast<uint32_t>( now - st->mSent.load( std::memory_order_acquire ) ) );
+  st->mReceived.fetch_add( size, std::memory_order_release );
+  }
+
+
+
+
+//!
+//! \brief csBenchPolicy Измерить задержку приема при заданной политике
+//! \param name          Название политики
+//! \param policy        Политика опроса
+//! \param count         Количество сообщений
+//! \return              true при успешном измерении
+//!
+static bool csBenchPolicy( const char *name, const CsPollPolicy &policy, int count )
+  {
+  int master = posix_openpt( O_RDWR | O_NOCTTY | O_CLOEXEC );
+  if( master < 0 || grantpt( master ) != 0 || unlockpt( master ) != 0 ) return false;
+  int slave = open( ptsname( master ), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC );
+  if( slave < 0 ) return false;
+  struct termios tio;
+  tcgetattr( slave, &tio );
+  cfmakeraw( &tio );
+  tio.c_cc[VMIN]  = 0;
+  tio.c_cc[VTIME] = 0;
+  tcsetattr( slave, TCSANOW, &tio );
+
+  CsBenchState st;
+  st.mSent = 0;
+  st.mReceived = 0;
+  st.mTimes.reserve( count );
+  CsBusyPoll rx( csBenchRx, &st, policy );
+  std::atomic<bool> stop(false);
+  bool ok = true;
+  std::thread thread( [&]() { ok = rx.run( slave, stop ); } );
+
+  unsigned seed = 1;
+  for( int i = 1; i <= count; i++ ) {
+    struct timespec pause = { 0, static_cast<long>( 100000 + rand_r( &seed ) % 400000 ) };
+    nanosleep( &pause, nullptr );
+    st.mSent.store( csTimeNs(), std::memory_order_release );
+    if( write( master, "\x81", 1 ) != 1 ) break;
+    //Следующий байт после приема предыдущего, чтобы задержки не складывались
+    uint64_t limit = csTimeNs() + 1000000000ull;
+    while( st.mReceived.load( std::memory_order_acquire ) < static_cast<uint32_t>(i) && csTimeNs() < limit )
+      sched_yield();
+    }
+  stop = true;
+  thread.join();
+  close( slave );
+  close( master );
+  if( !ok || st.mTimes.empty() ) return false;
+
+  std::vector<uint32_t> &times = st.mTimes;
+  std::sort( times.begin(), times.end() );
+  size_t n = times.size();
+  printf( "%-6s: median %6u ns, p99 %7u ns, max %8u ns, cpu load %.2f, empty polls %.3f\n", name,
+          times[n / 2], times[n * 99 / 100], times[n - 1], rx.stat().load(),
+          rx.stat().mPolls ? static_cast<double>(rx.stat().mEmpty) / rx.stat().mPolls : 0.0 );
+  return true;
+  }
+
+
+
+
+int main( int argc, char *argv[] )
+  {
+  int count = argc > 1 ? atoi( argv[1] ) : 2000;
+  if( count < 1 ) count = 1;
+
+  CsPollPolicy events;
+  events.mSpin  = 0;
+  events.mYield = 0;
+  CsPollPolicy yield;
+  yield.mSpin   = 0;
+  yield.mYield  = 1000000;
+  CsPollPolicy spin;
+  if( argc > 2 )
+    events.mCpu = yield.mCpu = spin.mCpu = atoi( argv[2] );
+
+  if( !csBenchPolicy( "events", events, count ) ||
+      !csBenchPolicy( "yield", yield, count ) ||
+      !csBenchPolicy( "spin", spin, count ) ) {
+    printf( "port error\n" );
+    return 1;
+    }
+  return 0;
+  }
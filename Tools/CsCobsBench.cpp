@@ -0,0 +1,142 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     cscobsbench - сравнение кадрирования обмена с хостом: упаковка по 7 бит
+     (CsMessageOutT::hostEnd, CsMessageIn) и COBS (CsCobsOutT, CsCobsIn)
+
+     Использование
+       cscobsbench [количество сообщений]
+     Для нескольких размеров данных сообщения кодируется и декодируется заданное
+     количество сообщений. Выводятся длина сообщения в линии, время процессора
+     на кодирование и декодирование одного сообщения и пропускная способность
+     по полезным данным.
+   */
+#include "CsCobs.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+//Максимальное количество 32-битных значений в сообщении
+#define CS_BENCH_VALUES 48
+
+
+//!
+//! \brief csCpuNs Возвращает время процессора текущего потока
+//! \return        Время, нс
+//!
+static uint64_t csCpuNs()
+  {
+  struct timespec ts;
+  clock_gettime( CLOCK_THREAD_CPUTIME_ID, &ts );
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+  }
+
+
+
+
+//!
+//! \brief csReport Вывести результат одного измерения
+//! \param name     Название кадрирования
+//! \param values   Количество 32-битных значений в сообщении
+//! \param wire     Длина сообщения в линии, байт
+//! \param count    Количество сообщений
+//! \param encNs    Время кодирования, нс
+//! \param decNs    Время декодирования, нс
+//!
+static void csReport( const char *name, int values, int wire, int count, uint64_t encNs, uint64_t decNs )
+  {
+  double payload = static_cast<double>(values) * 4 * count;
+  printf( "%-6s %3d bytes: wire %4d bytes, encode %6.1f ns (%7.1f MB/s), decode %6.1f ns (%7.1f MB/s)\n",
+          name, values * 4, wire,
+          static_cast<double>(encNs) / count, payload * 1000 / (encNs ? encNs : 1),
+          static_cast<double>(decNs) / count, payload * 1000 / (decNs ? decNs : 1) );
+  }
+
+
+
+
+//!
+//! \brief csBenchClassic Измерить упаковку по 7 бит
+//! \param values         Количество 32-битных значений в сообщении
+//! \param count          Количество сообщений
+//! \return               Контрольная сумма декодированных значений
+//!
+static int64_t csBenchClassic( int values, int count )
+  {
+  static CsMessageOutT<CS_BENCH_VALUES * 5 + 4> msg;
+  int64_t  check = 0;
+  uint64_t start = csCpuNs();
+  for( int i = 0; i < count; i++ ) {
+    msg.hostBeginQuery( 1 );
+    for( int k = 0; k < values; k++ )
+      msg.addInt32( i * 977 + k );
+    msg.hostEnd();
+    }
+  uint64_t encNs = csCpuNs() - start;
+
+  start = csCpuNs();
+  for( int i = 0; i < count; i++ ) {
+    CsMessageIn in( msg.buffer(), 0, msg.length(), 1 );
+    if( !in.checkCrc( msg.length() - 1 ) ) return -1;
+    for( int k = 0; k < values; k++ )
+      check += in.getInt32();
+    }
+  uint64_t decNs = csCpuNs() - start;
+  csReport( "7-bit", values, msg.length(), count, encNs, decNs );
+  return check;
+  }
+
+
+
+
+//!
+//! \brief csBenchCobs Измерить кадрирование COBS
+//! \param values      Количество 32-битных значений в сообщении
+//! \param count       Количество сообщений
+//! \return            Контрольная сумма декодированных значений
+//!
+static int64_t csBenchCobs( int values, int count )
+  {
+  static CsCobsOutT<CS_BENCH_VALUES * 4 + 2> msg;
+  int64_t  check = 0;
+  uint64_t start = csCpuNs();
+  for( int i = 0; i < count; i++ ) {
+    msg.hostBeginQuery( 1 );
+    for( int k = 0; k < values; k++ )
+      msg.addInt32( i * 977 + k );
+    msg.hostEnd();
+    }
+  uint64_t encNs = csCpuNs() - start;
+
+  start = csCpuNs();
+  for( int i = 0; i < count; i++ ) {
+    //Разделитель не входит в кадр
+    CsCobsIn in( msg.buffer(), msg.length() - 1 );
+    if( !in.valid() ) return -1;
+    for( int k = 0; k < values; k++ )
+      check += in.getInt32();
+    }
+  uint64_t decNs = csCpuNs() - start;
+  csReport( "COBS", values, msg.length(), count, encNs, decNs );
+  return check;
+  }
+
+
+
+
+int main( int argc, char *argv[] )
+  {
+  int count = argc > 1 ? atoi( argv[1] ) : 1000000;
+  if( count < 1 ) count = 1;
+  static const int sizes[] = { 1, 4, 16, CS_BENCH_VALUES };
+  for( int values : sizes ) {
+    int64_t classic = csBenchClassic( values, count );
+    int64_t cobs    = csBenchCobs( values, count );
+    if( classic < 0 || cobs < 0 ) {
+      printf( "decode failed\n" );
+      return 1;
+      }
+    }
+  return 0;
+  }
@@ -0,0 +1,46 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     csflashenc - кодирование образа прошивки в файл готовых сообщений
+
+     Использование
+       csflashenc образ.bin поток.zfl [id] [адрес] [потоки]
+     id по умолчанию CS_ID_BROADCAST, адрес по умолчанию 0, количество потоков
+     кодирования по умолчанию равно количеству процессоров.
+   */
+#include "CsFlashStream.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+int main( int argc, char *argv[] )
+  {
+  if( argc < 3 ) {
+    fprintf( stderr, "usage: %s image.bin stream.zfl [id] [base] [threads]\n", argv[0] );
+    return 1;
+    }
+  int      id      = argc > 3 ? static_cast<int>(strtol( argv[3], nullptr, 0 )) : CS_ID_BROADCAST;
+  uint32_t base    = argc > 4 ? static_cast<uint32_t>(strtoul( argv[4], nullptr, 0 )) : 0;
+  int      threads = argc > 5 ? atoi( argv[5] ) : static_cast<int>(std::thread::hardware_concurrency());
+
+  FILE *f = fopen( argv[1], "rb" );
+  if( f == nullptr ) {
+    perror( argv[1] );
+    return 1;
+    }
+  std::vector<char> image;
+  char block[4096];
+  size_t len;
+  while( (len = fread( block, 1, sizeof(block), f )) > 0 )
+    image.insert( image.end(), block, block + len );
+  fclose( f );
+
+  if( !csFlashEncodeFile( argv[2], image.data(), image.size(), base, id, threads ) ) {
+    perror( argv[2] );
+    return 1;
+    }
+  printf( "%s: %d frames for id %d\n", argv[2], static_cast<int>((image.size() + 3) / 4), id );
+  return 0;
+  }
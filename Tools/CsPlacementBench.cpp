@@ -0,0 +1,138 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     csplacebench - задержка передачи принятых сообщений между потоком обмена
+     с шиной и потоком управления в зависимости от их размещения по узлам NUMA
+
+     Использование
+       csplacebench [порт] [количество]
+     Если задан порт (без /dev/, например ttyUSB0), выводится размещение его
+     прерывания, и поток обмена размещается на узле прерывания. Поток обмена
+     выделяет кольцевой буфер из своего узла (first touch), записывает в него
+     сообщение и сообщает об этом потоку управления, который читает сообщение
+     и отвечает. Измеряется время полного обхода для потока управления на том же
+     узле и, если он есть, на другом узле.
+   */
+#include "CsPlacement.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <time.h>
+#include <vector>
+
+//Размер сообщения, передаваемого через кольцевой буфер
+#define CS_BENCH_FRAME 64
+
+//Количество пустых проверок до уступки процессора
+#define CS_BENCH_SPIN  1000
+
+
+//!
+//! \brief csTimeNs Возвращает монотонное время
+//! \return         Время, нс
+//!
+static uint64_t csTimeNs()
+  {
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+  }
+
+
+
+
+//!
+//! \brief csWaitFor Ожидать значения счетчика
+//! \param counter   Счетчик
+//! \param value     Ожидаемое значение
+//!
+static void csWaitFor( const std::atomic<uint32_t> &counter, uint32_t value )
+  {
+  int spin = 0;
+  while( counter.load( std::memory_order_acquire ) != value )
+    if( ++spin > CS_BENCH_SPIN ) {
+      sched_yield();
+      spin = 0;
+      }
+  }
+
+
+
+
+//!
+//! \brief csRoundTrip Измерить время обхода между потоками на заданных узлах
+//! \param ioNode      Узел потока обмена с шиной
+//! \param ctlNode     Узел потока управления
+//! \param count       Количество обходов
+//!
+static void csRoundTrip( int ioNode, int ctlNode, int count )
+  {
+  std::atomic<uint32_t> request(0);
+  std::atomic<uint32_t> answer(0);
+  std::atomic<char*>    ring(nullptr);
+  std::vector<uint32_t> times( count );
+
+  std::thread io( [&]() {
+    csBindToNode( ioNode );
+    //Кольцевой буфер размещается на узле потока обмена по первому обращению
+    std::vector<char> buffer( 4096, 0 );
+    ring.store( buffer.data(), std::memory_order_release );
+    for( int i = 1; i <= count; i++ ) {
+      csWaitFor( request, i );
+      memset( buffer.data() + (i * CS_BENCH_FRAME) % buffer.size(), i, CS_BENCH_FRAME );
+      answer.store( i, std::memory_order_release );
+      }
+    } );
+
+  std::thread ctl( [&]() {
+    csBindToNode( ctlNode );
+    while( ring.load( std::memory_order_acquire ) == nullptr ) sched_yield();
+    const char *buffer = ring.load();
+    unsigned    sum    = 0;
+    for( int i = 1; i <= count; i++ ) {
+      uint64_t start = csTimeNs();
+      request.store( i, std::memory_order_release );
+      csWaitFor( answer, i );
+      const char *frame = buffer + (i * CS_BENCH_FRAME) % 4096;
+      for( int k = 0; k < CS_BENCH_FRAME; k++ )
+        sum += static_cast<unsigned char>( frame[k] );
+      times[i - 1] = static_cast<uint32_t>( csTimeNs() - start );
+      }
+    if( sum == 0 ) printf( "unexpected empty frames\n" );
+    } );
+
+  io.join();
+  ctl.join();
+  std::sort( times.begin(), times.end() );
+  printf( "io node %d, control node %d: median %u ns, p99 %u ns, max %u ns\n", ioNode, ctlNode,
+          times[count / 2], times[count * 99 / 100], times[count - 1] );
+  }
+
+
+
+
+int main( int argc, char *argv[] )
+  {
+  int ioNode = 0;
+  if( argc > 1 ) {
+    CsBusPlacement placement = csPlaceBusThread( argv[1] );
+    printf( "%s: irq %d, node %d, cpu %d\n", argv[1], placement.mIrq, placement.mNode, placement.mCpu );
+    if( placement.mNode >= 0 ) ioNode = placement.mNode;
+    }
+  int count = argc > 2 ? atoi( argv[2] ) : 100000;
+  if( count < 1 ) count = 1;
+
+  csRoundTrip( ioNode, ioNode, count );
+  //Поток управления на любом другом узле
+  for( int node = 0; node < 64; node++ )
+    if( node != ioNode && csNodeCpuCount( node ) > 0 ) {
+      csRoundTrip( ioNode, node, count );
+      break;
+      }
+  return 0;
+  }
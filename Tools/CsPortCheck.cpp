@@ -0,0 +1,147 @@
+/*
+   Проект "Серводвигатель для роботов Zubr"
+   Описание
+     csportcheck - проверка восстановления порта шины после повторного подключения
+
+     Использование
+       csportcheck [количество переподключений]
+     Адаптер USB-serial заменяется псевдотерминалом: порт CsBusPort открывает
+     подчиненную сторону, а закрытие и повторное создание ведущей стороны
+     имитируют отключение и появление адаптера (узел /dev/pts/N удаляется и
+     создается заново с тем же номером). Для каждого переподключения проверяется:
+       - чтение из порта без данных возвращает 0 и не закрывает порт;
+       - данные ведущей стороны принимаются портом;
+       - после отключения чтение закрывает порт;
+       - CsHotplug, следящий за /dev/pts, и csHotplugApply открывают порт заново,
+         а generation() увеличивается.
+     Выводится время обнаружения отключения и время повторного открытия.
+     При любой ошибке программа завершается с кодом 1.
+   */
+#include "CsBusPort.hpp"
+
+#include <algorithm>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+//Скорость обмена порта, бод
+#define CS_CHECK_BAUD     1000000
+
+//Количество пустых чтений, которые не должны закрыть порт
+#define CS_CHECK_IDLE     100
+
+//Предельное время ожидания одного события, мс
+#define CS_CHECK_WAIT     1000
+
+
+//!
+//! \brief csTimeNs Возвращает монотонное время
+//! \return         Время, нс
+//!
+static uint64_t csTimeNs()
+  {
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+  }
+
+
+
+
+//!
+//! \brief csOpenMaster Создать псевдотерминал (подключить адаптер)
+//! \return             Дескриптор ведущей стороны или -1
+//!
+static int csOpenMaster()
+  {
+  int fd = posix_openpt( O_RDWR | O_NOCTTY | O_CLOEXEC );
+  if( fd < 0 ) return -1;
+  if( grantpt( fd ) != 0 || unlockpt( fd ) != 0 ) {
+    close( fd );
+    return -1;
+    }
+  return fd;
+  }
+
+
+
+
+//!
+//! \brief csFail Вывести сообщение об ошибке
+//! \param step   Этап проверки
+//! \param cycle  Номер переподключения
+//! \return       Код завершения программы
+//!
+static int csFail( const char *step, int cycle )
+  {
+  printf( "FAIL: %s (reconnect %d)\n", step, cycle );
+  return 1;
+  }
+
+
+
+
+int main( int argc, char *argv[] )
+  {
+  int count = argc > 1 ? atoi( argv[1] ) : 100;
+  if( count < 1 ) count = 1;
+
+  CsHotplug hotplug;
+  if( !hotplug.open( "/dev/pts" ) ) return csFail( "inotify on /dev/pts", 0 );
+  int master = csOpenMaster();
+  CsBusPort port;
+  if( master < 0 || !port.open( ptsname( master ), CS_CHECK_BAUD ) ) return csFail( "open pty", 0 );
+  //События создания первого узла уже учтены открытием порта
+  CsHotplugEvent events[16];
+  while( hotplug.read( events, 16 ) > 0 );
+
+  std::vector<uint32_t> detect, recover;
+  char buf[256];
+  for( int cycle = 0; cycle < count; cycle++ ) {
+    //Пустые чтения не означают потерю устройства
+    for( int i = 0; i < CS_CHECK_IDLE; i++ )
+      if( port.read( buf, sizeof(buf) ) != 0 || !port.isOpen() ) return csFail( "idle read closed the port", cycle );
+
+    if( write( master, "\x81\x82\x83", 3 ) != 3 ) return csFail( "write to master", cycle );
+    int got = 0;
+    for( uint64_t limit = csTimeNs() + CS_CHECK_WAIT * 1000000ull; got < 3 && csTimeNs() < limit; ) {
+      int len = port.read( buf + got, sizeof(buf) - got );
+      if( len < 0 ) return csFail( "port lost while receiving", cycle );
+      got += len;
+      }
+    if( got != 3 ) return csFail( "data not received", cycle );
+
+    //Отключение: порт должен закрыться при первом чтении после разрыва
+    uint32_t generation = port.generation();
+    uint64_t start = csTimeNs();
+    close( master );
+    while( port.read( buf, sizeof(buf) ) >= 0 )
+      if( csTimeNs() - start > CS_CHECK_WAIT * 1000000ull ) return csFail( "hangup not detected", cycle );
+    detect.push_back( static_cast<uint32_t>( csTimeNs() - start ) );
+
+    //Повторное подключение: узел получает тот же номер, порт открывается по событию
+    start  = csTimeNs();
+    master = csOpenMaster();
+    if( master < 0 ) return csFail( "reconnect pty", cycle );
+    while( !port.isOpen() ) {
+      struct pollfd pfd = { hotplug.fd(), POLLIN, 0 };
+      if( poll( &pfd, 1, CS_CHECK_WAIT ) <= 0 ) return csFail( "port not reopened", cycle );
+      int n = hotplug.read( events, 16 );
+      csHotplugApply( port, events, n );
+      }
+    recover.push_back( static_cast<uint32_t>( csTimeNs() - start ) );
+    if( port.generation() != generation + 1 ) return csFail( "generation not advanced", cycle );
+    }
+  close( master );
+
+  std::sort( detect.begin(), detect.end() );
+  std::sort( recover.begin(), recover.end() );
+  printf( "%d reconnects: hangup detected in median %u ns (max %u ns), reopened in median %u ns (max %u ns)\n",
+          count, detect[count / 2], detect[count - 1], recover[count / 2], recover[count - 1] );
+  printf( "OK\n" );
+  return 0;
+  }